@@ -175,8 +175,8 @@ void app::on_mouse_cursor(float x, float y)
 
 void app::create_top_pane()
 {
-	_vekt_root->get_data_widget().child_positioning = vekt::child_positioning::column;
-	_vekt_root->get_data_widget().spacing			= 0.0f;
+	_vekt_root->set_child_positioning(vekt::child_positioning::column);
+	_vekt_root->set_spacing(0.0f);
 
 	vekt::widget* top_pane = _vekt_builder->allocate();
 	{
@@ -202,8 +202,8 @@ void app::create_bottom_pane()
 		bottom->set_pos_x(0.0f, vekt::helper_pos_type::relative);
 		bottom->set_width(1.0f, vekt::helper_size_type::relative);
 		bottom->set_height(0.0f, vekt::helper_size_type::fill);
-		bottom->get_data_widget().child_positioning = vekt::child_positioning::row;
-		bottom->get_data_widget().debug_name		= "Bottom";
+		bottom->set_child_positioning(vekt::child_positioning::row);
+		bottom->get_data_widget().debug_name = "Bottom";
 		_vekt_root->add_child(bottom);
 	}
 
@@ -213,13 +213,15 @@ void app::create_bottom_pane()
 			pane->set_pos_y(0.0f, vekt::helper_pos_type::relative);
 			pane->set_height(1.0f, vekt::helper_size_type::relative);
 			pane->set_width(0.0f, vekt::helper_size_type::fill);
-			pane->get_data_widget().margins.left	  = theme::margin_horizontal;
-			pane->get_data_widget().margins.right	  = theme::margin_horizontal;
-			pane->get_data_widget().margins.top		  = theme::margin_horizontal;
-			pane->get_data_widget().margins.bottom	  = theme::margin_horizontal;
-			pane->get_data_widget().spacing			  = theme::margin_horizontal;
-			pane->get_data_widget().child_positioning = vekt::child_positioning::column;
-			pane->get_data_widget().debug_name		  = name;
+			pane->set_margins({
+				.top	= theme::margin_horizontal,
+				.bottom = theme::margin_horizontal,
+				.left	= theme::margin_horizontal,
+				.right	= theme::margin_horizontal,
+			});
+			pane->set_spacing(theme::margin_horizontal);
+			pane->set_child_positioning(vekt::child_positioning::column);
+			pane->get_data_widget().debug_name = name;
 
 			vekt::gfx_filled_rect& r = pane->get_gfx_filled_rect();
 			r.color_start = r.color_end = theme::color_dark1;
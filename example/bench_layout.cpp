@@ -0,0 +1,168 @@
+// Headless microbenchmark of the layout position/size step: the per-flag branch cascade layout used to run against the kernel tables it runs now.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#define VEKT_IMPL
+#include "vekt.hpp"
+
+using namespace vekt;
+
+namespace
+{
+	constexpr unsigned int container_count = 2000;
+	constexpr unsigned int children_count  = 100;
+	constexpr unsigned int iterations	   = 50;
+
+	// The branches pos_pass and size_pass took before the kernel tables.
+	void cascade_pos(layout_arena& a, unsigned int i)
+	{
+		const unsigned int flags = a.flags[i];
+		const unsigned int p	 = a.parent[i];
+		vec2&			   pos	 = a.final_pos[i];
+
+		if (flags & widget_flags::wf_pos_x_absolute)
+			pos.x = a.pos[i].x;
+		else if (p != layout_arena::no_entry && flags & widget_flags::wf_pos_x_relative)
+		{
+			const float parent_width = a.final_size[p].x - a.margins[p].left - a.margins[p].right;
+
+			if (flags & widget_flags::wf_pos_anchor_x_end)
+				pos.x = (a.final_pos[p].x + a.margins[p].left) + (parent_width * a.pos[i].x) - a.final_size[i].x;
+			else if (flags & widget_flags::wf_pos_anchor_x_center)
+				pos.x = (a.final_pos[p].x + a.margins[p].left) + (parent_width * a.pos[i].x) - a.final_size[i].x * 0.5f;
+			else
+				pos.x = (a.final_pos[p].x + a.margins[p].left) + (parent_width * a.pos[i].x);
+		}
+
+		if (flags & widget_flags::wf_pos_y_absolute)
+			pos.y = a.pos[i].y;
+		else if (p != layout_arena::no_entry && flags & widget_flags::wf_pos_y_relative)
+		{
+			const float parent_height = a.final_size[p].y - a.margins[p].top - a.margins[p].bottom;
+
+			if (flags & widget_flags::wf_pos_anchor_y_end)
+				pos.y = (a.final_pos[p].y + a.margins[p].top) + (parent_height * a.pos[i].y) - a.final_size[i].y;
+			else if (flags & widget_flags::wf_pos_anchor_y_center)
+				pos.y = (a.final_pos[p].y + a.margins[p].top) + (parent_height * a.pos[i].y) - a.final_size[i].y * 0.5f;
+			else
+				pos.y = (a.final_pos[p].y + a.margins[p].top) + (parent_height * a.pos[i].y);
+		}
+	}
+
+	void cascade_size(layout_arena& a, unsigned int i)
+	{
+		const unsigned int flags = a.flags[i];
+		const unsigned int p	 = a.parent[i];
+		vec2&			   size	 = a.final_size[i];
+
+		if (flags & widget_flags::wf_size_x_absolute)
+			size.x = a.size[i].x;
+		else if (p != layout_arena::no_entry && flags & widget_flags::wf_size_x_relative)
+			size.x = (a.final_size[p].x - a.margins[p].left - a.margins[p].right) * a.size[i].x;
+
+		if (flags & widget_flags::wf_size_y_absolute)
+			size.y = a.size[i].y;
+		else if (p != layout_arena::no_entry && flags & widget_flags::wf_size_y_relative)
+			size.y = (a.final_size[p].y - a.margins[p].top - a.margins[p].bottom) * a.size[i].y;
+
+		if (flags & widget_flags::wf_size_x_copy_y)
+			size.x = size.y * (flags & widget_flags::wf_size_x_relative ? a.size[i].x : 1.0f);
+		else if (flags & widget_flags::wf_size_y_copy_x)
+			size.y = size.x * (flags & widget_flags::wf_size_y_relative ? a.size[i].y : 1.0f);
+	}
+
+	void kernel_pos(layout_arena& a, unsigned int i) { pos_kernels::table[a.pos_kernel[i]](a, i); }
+	void kernel_size(layout_arena& a, unsigned int i) { size_kernels::table[a.size_kernel[i]](a, i); }
+
+	// Flag sets the widget setters produce, copying an axis never keeps it relative.
+	unsigned int random_flags(std::mt19937& rng)
+	{
+		static constexpr unsigned int pos_x[]  = {0, wf_pos_x_absolute, wf_pos_x_relative, wf_pos_x_relative | wf_pos_anchor_x_center, wf_pos_x_relative | wf_pos_anchor_x_end};
+		static constexpr unsigned int pos_y[]  = {0, wf_pos_y_absolute, wf_pos_y_relative, wf_pos_y_relative | wf_pos_anchor_y_center, wf_pos_y_relative | wf_pos_anchor_y_end};
+		static constexpr unsigned int size_x[] = {wf_size_x_absolute, wf_size_x_relative, wf_size_x_copy_y};
+		static constexpr unsigned int size_y[] = {wf_size_y_absolute, wf_size_y_relative};
+
+		return pos_x[rng() % 5] | pos_y[rng() % 5] | size_x[rng() % 3] | size_y[rng() % 2];
+	}
+
+	template <typename Pos, typename Size>
+	double run(layout_arena& a, Pos pos, Size size)
+	{
+		const unsigned int count = a.get_count();
+		const auto		   start = std::chrono::high_resolution_clock::now();
+
+		// Parents come before children, size then position like the layout passes.
+		for (unsigned int it = 0; it < iterations; it++)
+		{
+			for (unsigned int i = 0; i < count; i++)
+				size(a, i);
+			for (unsigned int i = 0; i < count; i++)
+				pos(a, i);
+		}
+
+		const auto end = std::chrono::high_resolution_clock::now();
+		return std::chrono::duration<double, std::nano>(end - start).count() / (static_cast<double>(count) * iterations);
+	}
+}
+
+int main()
+{
+	const unsigned int count = 1 + container_count * (1 + children_count);
+	layout_arena	   a;
+	a.init(count);
+
+	std::mt19937 rng(7);
+
+	const unsigned int root = a.add(0);
+	a.flags[root]			= wf_pos_x_absolute | wf_pos_y_absolute | wf_size_x_absolute | wf_size_y_absolute;
+	a.size[root]			= {1920.0f, 1080.0f};
+
+	for (unsigned int c = 0; c < container_count; c++)
+	{
+		const unsigned int container = a.add(a.get_count());
+		a.parent[container]			 = root;
+		a.flags[container]			 = random_flags(rng);
+		a.pos[container]			 = {0.1f, 0.2f};
+		a.size[container]			 = {0.5f, 0.25f};
+		a.margins[container]		 = {4.0f, 4.0f, 2.0f, 2.0f};
+
+		for (unsigned int k = 0; k < children_count; k++)
+		{
+			const unsigned int child = a.add(a.get_count());
+			a.parent[child]			 = container;
+			a.flags[child]			 = random_flags(rng);
+			a.pos[child]			 = {static_cast<float>(rng() % 100) * 0.01f, static_cast<float>(rng() % 100) * 0.01f};
+			a.size[child]			 = {static_cast<float>(rng() % 100) * 0.01f, static_cast<float>(rng() % 100) * 0.01f};
+		}
+
+		a.subtree_end[container] = a.get_count();
+	}
+
+	a.subtree_end[root] = a.get_count();
+	for (unsigned int i = 0; i < count; i++)
+		a.resolve_kernels(i);
+
+	// Warm up, then both have to agree before their timings mean anything.
+	run(a, cascade_pos, cascade_size);
+	pod_vector<vec2> cascade_positions = a.final_pos, cascade_sizes = a.final_size;
+	run(a, kernel_pos, kernel_size);
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		if (a.final_pos[i] != cascade_positions[i] || a.final_size[i] != cascade_sizes[i])
+		{
+			printf("mismatch at entry %u\n", i);
+			return 1;
+		}
+	}
+
+	const double cascade = run(a, cascade_pos, cascade_size);
+	const double kernels = run(a, kernel_pos, kernel_size);
+	printf("entries: %u, iterations: %u\n", count, iterations);
+	printf("flag cascade: %.2f ns/entry\n", cascade);
+	printf("kernel table: %.2f ns/entry\n", kernels);
+	a.uninit();
+	return 0;
+}
@@ -0,0 +1,195 @@
+// Headless layout checks, returns non zero and names the failing case when one breaks.
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#define VEKT_IMPL
+#include "vekt.hpp"
+
+using namespace vekt;
+
+namespace
+{
+	unsigned int failures = 0;
+
+	void check(bool condition, const char* name)
+	{
+		if (condition) return;
+		printf("failed: %s\n", name);
+		failures++;
+	}
+
+	widget* add_box(builder& b, widget* parent, float width, float height)
+	{
+		widget* w = b.allocate();
+		w->set_width(width, helper_size_type::absolute);
+		w->set_height(height, helper_size_type::absolute);
+		parent->add_child(w);
+		return w;
+	}
+
+	// Stacked children that each fit the width keep it, even once their widths add up past the column's.
+	void column_cross_axis_shrink()
+	{
+		builder b;
+		b.init({});
+		widget* root = b.allocate();
+		b.set_root(root);
+
+		widget* column = add_box(b, root, 100.0f, 300.0f);
+		column->set_child_positioning(child_positioning::column);
+
+		widget* children[3];
+		for (widget*& c : children)
+		{
+			c = add_box(b, column, 80.0f, 20.0f);
+			c->set_shrink({1.0f, 1.0f});
+		}
+
+		// Wider than the column on its own, so it is cut to the column's width.
+		widget* wide = add_box(b, column, 150.0f, 20.0f);
+		wide->set_shrink({1.0f, 0.0f});
+
+		b.build({1000.0f, 1000.0f});
+		for (widget* c : children)
+			check(c->get_final_size().x == 80.0f && c->get_final_size().y == 20.0f, "column children keep their widths");
+		check(wide->get_final_size().x == 100.0f, "column child wider than the column fits it");
+		b.uninit();
+	}
+
+	// A fill child takes its width after the lines broke, it still wraps onto its own line once that width no longer fits next to its sibling.
+	void wrap_breaks_after_fill()
+	{
+		builder b;
+		b.init({});
+		widget* root = b.allocate();
+		b.set_root(root);
+
+		widget* container = add_box(b, root, 100.0f, 0.0f);
+		container->set_child_positioning(child_positioning::wrap);
+		container->set_spacing(10.0f);
+		container->set_height(0.0f, helper_size_type::total_children);
+
+		widget* fixed = add_box(b, container, 60.0f, 20.0f);
+		widget* fill  = add_box(b, container, 0.0f, 20.0f);
+		fill->set_width(0.0f, helper_size_type::fill);
+
+		b.build({1000.0f, 1000.0f});
+		check(fill->get_final_size().x == 40.0f, "wrap fill child takes the free width");
+		check(fill->get_final_pos().x == fixed->get_final_pos().x && fill->get_final_pos().y == fixed->get_final_pos().y + 30.0f, "wrap fill child breaks onto the next line");
+		check(container->get_final_size().y == 50.0f, "wrap container height counts both lines");
+		b.uninit();
+	}
+
+	// Only builds after something changed report it, edits made through the gfx accessors count, a due request that changed nothing doesn't.
+	void build_reports_changes()
+	{
+		builder b;
+		b.init({});
+		widget* root = b.allocate();
+		b.set_root(root);
+
+		widget* box = add_box(b, root, 50.0f, 50.0f);
+		box->set_gfx_type_filled_rect();
+
+		check(b.build({1000.0f, 1000.0f}).changed, "first build reports a change");
+		check(!b.build({1000.0f, 1000.0f}).changed, "idle build reports no change");
+
+		box->get_gfx_filled_rect().color_start = {1.0f, 0.0f, 0.0f, 1.0f};
+		check(b.build({1000.0f, 1000.0f}).changed, "gfx accessor edit reports a change");
+
+		b.request_redraw(0.0);
+		check(!b.build({1000.0f, 1000.0f}, 1.0).changed, "due request without edits reports no change");
+		b.uninit();
+	}
+
+	// Builds the same random tree of row, column and free containers with fill, relative and absolute children, nested leaves included.
+	void make_tree(builder& b, pod_vector<widget*>& widgets)
+	{
+		std::mt19937 rng(11);
+		widget*		 root = b.allocate();
+		b.set_root(root);
+
+		const child_positioning positionings[] = {child_positioning::none, child_positioning::row, child_positioning::column};
+		for (unsigned int g = 0; g < 20; g++)
+		{
+			widget* group = b.allocate();
+			group->set_pos_x(static_cast<float>(g % 5) * 200.0f, helper_pos_type::absolute);
+			group->set_pos_y(static_cast<float>(g / 5) * 200.0f, helper_pos_type::absolute);
+			group->set_width(0.2f);
+			if (rng() % 2)
+				group->set_height(0.0f, helper_size_type::total_children);
+			else
+				group->set_height(0.25f);
+			group->set_child_positioning(positionings[rng() % 3]);
+			root->add_child(group);
+			widgets.push_back(group);
+
+			for (unsigned int c = 0; c < 30; c++)
+			{
+				widget*			   w	= b.allocate();
+				const unsigned int kind = rng() % 3;
+				if (kind == 0)
+					w->set_width(0.0f, helper_size_type::fill);
+				else if (kind == 1)
+					w->set_width(static_cast<float>(rng() % 100) * 0.01f);
+				else
+					w->set_width(static_cast<float>(rng() % 40), helper_size_type::absolute);
+				w->set_height(static_cast<float>(rng() % 20 + 1), helper_size_type::absolute);
+				group->add_child(w);
+				widgets.push_back(w);
+
+				for (unsigned int k = 0; rng() % 3 == 0 && k < 20; k++)
+				{
+					widget* leaf = b.allocate();
+					leaf->set_width(0.5f);
+					leaf->set_height(4.0f, helper_size_type::absolute);
+					w->add_child(leaf);
+					widgets.push_back(leaf);
+				}
+			}
+		}
+	}
+
+	// Subtrees handed to the task pool have to settle exactly where the serial passes put them, build after build.
+	void parallel_matches_serial()
+	{
+		builder serial, parallel;
+		serial.init({.widget_buffer_sz = 1024 * 1024 * 8});
+		parallel.init({.widget_buffer_sz = 1024 * 1024 * 8, .layout_thread_count = 4, .layout_task_min_entries = 16});
+
+		pod_vector<widget*> serial_widgets, parallel_widgets;
+		make_tree(serial, serial_widgets);
+		make_tree(parallel, parallel_widgets);
+
+		std::mt19937 rng(5);
+		bool		 same = serial_widgets.size() == parallel_widgets.size();
+		for (unsigned int frame = 0; frame < 100 && same; frame++)
+		{
+			const unsigned int k	  = rng() % serial_widgets.size();
+			const float		   height = static_cast<float>(rng() % 50 + 1);
+			serial_widgets[k]->set_height(height, helper_size_type::absolute);
+			parallel_widgets[k]->set_height(height, helper_size_type::absolute);
+			serial.build({1000.0f, 1000.0f});
+			parallel.build({1000.0f, 1000.0f});
+
+			for (unsigned int i = 0; i < serial_widgets.size() && same; i++)
+				same = serial_widgets[i]->get_final_pos() == parallel_widgets[i]->get_final_pos() && serial_widgets[i]->get_final_size() == parallel_widgets[i]->get_final_size();
+		}
+
+		check(same, "parallel layout matches serial layout");
+		serial.uninit();
+		parallel.uninit();
+	}
+}
+
+int main()
+{
+	column_cross_axis_shrink();
+	wrap_breaks_after_fill();
+	parallel_matches_serial();
+	build_reports_changes();
+
+	if (failures == 0) printf("all layout checks passed\n");
+	return failures == 0 ? 0 : 1;
+}
@@ -7,9 +7,15 @@
 #include <assert.h>
 #include <algorithm>
 #include <cmath>
+#include <cfloat>
 #include <fstream>
 #include <functional>
 #include <utility> // For std::swap, std::move
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 #ifndef VEKT_STRING
 #include <string>
@@ -19,6 +25,23 @@
 #include <variant>
 #endif
 
+#if !defined(VEKT_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define VEKT_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX2 kernels are compiled for their own functions only and picked at runtime, builds don't need -mavx2 and run on CPUs without it.
+#if defined(VEKT_SSE2) && !defined(VEKT_NO_AVX2) && (defined(__x86_64__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#define VEKT_AVX2
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define VEKT_TARGET_AVX2
+#else
+#define VEKT_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
 #define VEKT_INLINE inline
 #define VEKT_API	extern
 
@@ -195,8 +218,12 @@ namespace vekt
 			_elements = reinterpret_cast<T*>(MALLOC(_capacity * sizeof(T)));
 			if (!_elements) { throw std::bad_alloc(); }
 
+			// Elements may own memory themselves, so they are copied like the copy constructor does rather than byte for byte.
+			for (unsigned int i = 0; i < other._count; ++i)
+			{
+				new (&_elements[i]) T(other._elements[i]);
+			}
 			_count = other._count;
-			MEMCPY(_elements, other._elements, _count * sizeof(T));
 
 			return *this;
 		}
@@ -426,6 +453,8 @@ namespace vekt
 			return elem;
 		}
 
+		inline T* get(unsigned int index) { return &_elements[index]; }
+
 		inline void deallocate(T* ptr)
 		{
 			ASSERT(ptr);
@@ -483,6 +512,55 @@ namespace vekt
 		pod_vector<unsigned int> _freelist = {};
 	};
 
+	////////////////////////////////////////////////////////////////////////////////
+	// :: TASK POOL
+	////////////////////////////////////////////////////////////////////////////////
+
+	// Small work-stealing pool. Every worker pushes to and pops from the back of its own queue, idle workers steal from the front of the others.
+	// Worker 0 is the thread that owns the pool, it only runs tasks while it waits on them.
+	class task_pool
+	{
+	public:
+		typedef void (*task_func)(void* owner, unsigned int arg, unsigned int worker);
+
+		struct task
+		{
+			task_func				   func	   = nullptr;
+			void*					   owner   = nullptr;
+			unsigned int			   arg	   = 0;
+			std::atomic<unsigned int>* pending = nullptr;
+		};
+
+		task_pool()						  = default;
+		task_pool(const task_pool& other) = delete;
+		~task_pool() { uninit(); }
+
+		void init(unsigned int worker_count);
+		void uninit();
+		void push(unsigned int worker, task_func func, void* owner, unsigned int arg, std::atomic<unsigned int>& pending);
+		void wait(unsigned int worker, std::atomic<unsigned int>& pending);
+
+		inline unsigned int get_worker_count() const { return _worker_count; }
+
+	private:
+		struct queue
+		{
+			std::mutex		 mtx;
+			std::deque<task> tasks;
+		};
+
+		bool try_run(unsigned int worker);
+		void worker_loop(unsigned int worker);
+
+		queue*					  _queues  = nullptr;
+		std::thread*			  _threads = nullptr;
+		std::mutex				  _sleep_mtx;
+		std::condition_variable	  _sleep_cv;
+		std::atomic<unsigned int> _queued		= 0;
+		std::atomic<bool>		  _stop			= false;
+		unsigned int			  _worker_count = 0;
+	};
+
 	////////////////////////////////////////////////////////////////////////////////
 	// :: VECTORS & MATH
 	////////////////////////////////////////////////////////////////////////////////
@@ -544,6 +622,9 @@ namespace vekt
 			return *this;
 		}
 
+		bool operator==(const vec2& other) const { return x == other.x && y == other.y; }
+		bool operator!=(const vec2& other) const { return x != other.x || y != other.y; }
+
 		inline void normalize()
 		{
 			const float s = mag();
@@ -575,14 +656,71 @@ namespace vekt
 		{
 			return a < b ? a : b;
 		}
+		template <typename T>
+		static inline T clamp(T v, T min, T max)
+		{
+			return v > max ? (max < min ? min : max) : (v < min ? min : v);
+		}
 		static inline float equals(float a, float b, float eps = 0.0001f) { return a > b - eps && a < b + eps; }
 		static inline float cos(float x) { return std::cos(x); }
 		static inline float sin(float x) { return std::sin(x); }
+		static inline float acos(float x) { return std::acos(x); }
 		static inline float lerp(float a, float b, float t) { return a + (b - a) * t; }
 		static inline float ceilf(float f) { return std::ceilf(f); }
 		static inline float remap(float val, float from_low, float from_high, float to_low, float to_high) { return to_low + (val - from_low) * (to_high - to_low) / (from_high - from_low); }
+
+		// Taylor series, only meant for building tables at compile time within [0, pi / 2].
+		static constexpr double sin_cx(double x)
+		{
+			double term = x, sum = x;
+			for (int i = 1; i < 12; i++)
+			{
+				term *= -x * x / ((2 * i) * (2 * i + 1));
+				sum += term;
+			}
+			return sum;
+		}
+		static constexpr double cos_cx(double x)
+		{
+			double term = 1.0, sum = 1.0;
+			for (int i = 1; i < 12; i++)
+			{
+				term *= -x * x / ((2 * i - 1) * (2 * i));
+				sum += term;
+			}
+			return sum;
+		}
+	};
+
+	// (sin, cos) of a quarter circle split into every segment count from 1 to max_segments, laid out back to back.
+	// Rounded corners are scale and offset of these instead of trig per point.
+	struct unit_arcs
+	{
+		static constexpr int max_segments = 90;
+		static constexpr int point_count  = (max_segments + 1) * (max_segments + 2) / 2 - 1;
+
+		vec2 points[point_count] = {};
+		int	 offsets[max_segments + 1] = {};
+
+		constexpr unit_arcs()
+		{
+			int head = 0;
+			for (int s = 1; s <= max_segments; s++)
+			{
+				offsets[s] = head;
+				for (int i = 0; i <= s; i++)
+				{
+					const double angle = 1.57079632679489661923 * i / s;
+					points[head++]	   = {static_cast<float>(math::sin_cx(angle)), static_cast<float>(math::cos_cx(angle))};
+				}
+			}
+		}
+
+		constexpr const vec2* get(int segments) const { return points + offsets[segments]; }
 	};
 
+	static constexpr unit_arcs g_unit_arcs = {};
+
 	struct vec4
 	{
 		float x = 0.0f;
@@ -591,6 +729,7 @@ namespace vekt
 		float w = 0.0f;
 
 		bool equals(const vec4& other) const { return math::equals(x, other.x, 0.1f) && math::equals(y, other.y, 0.1f) && math::equals(z, other.z, 0.1f) && math::equals(w, other.w, 0.1f); }
+		bool operator==(const vec4& other) const { return x == other.x && y == other.y && z == other.z && w == other.w; }
 		bool is_point_inside(const vec2& point) const { return point.x >= x && point.x <= x + z && point.y >= y && point.y <= y + w; }
 
 		static inline vec4 lerp(const vec4& a, const vec4& b, float t) { return vec4(math::lerp(a.x, b.x, t), math::lerp(a.y, b.y, t), math::lerp(a.z, b.z, t), math::lerp(a.w, b.w, t)); }
@@ -605,6 +744,16 @@ namespace vekt
 			return v;
 		}
 
+		vec4 operator-(const vec4& other) const
+		{
+			vec4 v = {};
+			v.x	   = x - other.x;
+			v.y	   = y - other.y;
+			v.z	   = z - other.z;
+			v.w	   = w - other.w;
+			return v;
+		}
+
 		vec4 operator*(float f) const
 		{
 			vec4 v = *this;
@@ -616,6 +765,56 @@ namespace vekt
 		}
 	};
 
+	// 2D affine transform, maps p to (a * p.x + c * p.y + tx, b * p.x + d * p.y + ty).
+	struct affine
+	{
+		float a	 = 1.0f;
+		float b	 = 0.0f;
+		float c	 = 0.0f;
+		float d	 = 1.0f;
+		float tx = 0.0f;
+		float ty = 0.0f;
+
+		inline bool is_identity() const { return a == 1.0f && b == 0.0f && c == 0.0f && d == 1.0f && tx == 0.0f && ty == 0.0f; }
+		inline vec2 apply(const vec2& p) const { return {a * p.x + c * p.y + tx, b * p.x + d * p.y + ty}; }
+
+		// Bounding box of the transformed rect, rect is x, y, width, height.
+		inline vec4 apply_rect(const vec4& r) const
+		{
+			const vec2 p0 = apply({r.x, r.y});
+			const vec2 p1 = apply({r.x + r.z, r.y});
+			const vec2 p2 = apply({r.x + r.z, r.y + r.w});
+			const vec2 p3 = apply({r.x, r.y + r.w});
+			const vec2 lo = {math::min(math::min(p0.x, p1.x), math::min(p2.x, p3.x)), math::min(math::min(p0.y, p1.y), math::min(p2.y, p3.y))};
+			const vec2 hi = {math::max(math::max(p0.x, p1.x), math::max(p2.x, p3.x)), math::max(math::max(p0.y, p1.y), math::max(p2.y, p3.y))};
+			return {lo.x, lo.y, hi.x - lo.x, hi.y - lo.y};
+		}
+
+		// False for a singular transform, like a zero scale, which collapses everything to no area and has no inverse.
+		inline bool inverse(affine& out) const
+		{
+			const float det = a * d - b * c;
+			if (math::equals(det, 0.0f, 1e-8f)) return false;
+			const float inv = 1.0f / det;
+			out				= {d * inv, -b * inv, -c * inv, a * inv, (c * ty - d * tx) * inv, (b * tx - a * ty) * inv};
+			return true;
+		}
+
+		// Applies other first, then this.
+		affine operator*(const affine& o) const { return {a * o.a + c * o.b, b * o.a + d * o.b, a * o.c + c * o.d, b * o.c + d * o.d, a * o.tx + c * o.ty + tx, b * o.tx + d * o.ty + ty}; }
+
+		// Scales and rotates (radians) around pivot, then translates.
+		static inline affine make(const vec2& translation, const vec2& scale, float rotation, const vec2& pivot)
+		{
+			const float cs = math::cos(rotation);
+			const float sn = math::sin(rotation);
+			affine		m  = {cs * scale.x, sn * scale.x, -sn * scale.y, cs * scale.y, 0.0f, 0.0f};
+			m.tx		   = pivot.x + translation.x - (m.a * pivot.x + m.c * pivot.y);
+			m.ty		   = pivot.y + translation.y - (m.b * pivot.x + m.d * pivot.y);
+			return m;
+		}
+	};
+
 	////////////////////////////////////////////////////////////////////////////////
 	// :: INPUT
 	////////////////////////////////////////////////////////////////////////////////
@@ -699,6 +898,8 @@ namespace vekt
 		none,
 		row,
 		column,
+		wrap,
+		grid,
 	};
 
 	enum class helper_size_type
@@ -776,6 +977,7 @@ namespace vekt
 	struct font;
 	struct gfx_text
 	{
+		widget*		 _widget				= nullptr;
 		VEKT_STRING	 _text					= "";
 		font*		 _font					= nullptr;
 		unsigned int spacing				= 0;
@@ -786,31 +988,21 @@ namespace vekt
 		direction	 color_direction		= direction::horizontal;
 		float		 _scale					= 1.0f;
 		float		 _parent_relative_scale = 0.0f;
-		bool		 _dirty					= true;
-
-		inline void set_text(const VEKT_STRING& txt)
-		{
-			_text  = txt;
-			_dirty = true;
-		}
 
-		inline void set_font(font* fnt)
-		{
-			_font  = fnt;
-			_dirty = true;
-		}
+		inline void set_text(const VEKT_STRING& txt);
+		inline void set_font(font* fnt);
+		inline void set_scale(float s);
+		inline void set_parent_relative_scale(float f);
+	};
 
-		inline void set_scale(float s)
-		{
-			_scale = s;
-			_dirty = true;
-		}
+	// Applied to the widget's vertices and inherited by its children at draw time, scale and rotation pivot around the widget's center. Layout never sees it.
+	struct widget_transform
+	{
+		vec2  translation = {};
+		vec2  scale		  = {1.0f, 1.0f};
+		float rotation	  = 0.0f;
 
-		inline void set_parent_relative_scale(float f)
-		{
-			_parent_relative_scale = f;
-			_dirty				   = true;
-		}
+		inline bool is_identity() const { return translation == vec2() && scale == vec2(1.0f, 1.0f) && rotation == 0.0f; }
 	};
 
 	struct widget_gfx
@@ -818,9 +1010,11 @@ namespace vekt
 
 		VEKT_VARIANT<gfx_text, gfx_filled_rect, gfx_stroke_rect> gfx;
 
-		void*		 user_data	= nullptr;
-		gfx_type	 type		= gfx_type::none;
-		unsigned int draw_order = 0;
+		void*			 user_data	= nullptr;
+		gfx_type		 type		= gfx_type::none;
+		unsigned int	 draw_order = 0;
+		widget_transform transform	= {};
+		float			 opacity	= 1.0f;
 
 		template <typename T>
 		T& get_data()
@@ -834,6 +1028,16 @@ namespace vekt
 	////////////////////////////////////////////////////////////////////////////////
 
 	typedef std::function<void(widget*)> custom_func;
+	typedef void (*layout_policy_func)(widget* w, void* context);
+
+	// Custom size or position pass shared by any number of widgets, which refer to it by the id builder::register_layout_policy() returned.
+	// A cacheable size policy promises to only read the widget's own properties, its parent's size and the size it was given, so it is skipped while those and its children stay the same.
+	struct layout_policy
+	{
+		layout_policy_func func		 = nullptr;
+		void*			   context	 = nullptr;
+		bool			   cacheable = false;
+	};
 
 	struct widget_data
 	{
@@ -846,21 +1050,170 @@ namespace vekt
 		custom_click_event		 on_mouse_clicked  = nullptr;
 		custom_mouse_drag_event	 on_mouse_dragged  = nullptr;
 		custom_key_event		 on_key			   = nullptr;
-		custom_func				 custom_pos_pass   = nullptr;
-		custom_func				 custom_size_pass  = nullptr;
 		pod_vector<widget*>		 children		   = {};
-		child_positioning		 child_positioning = child_positioning::none;
-		margins					 margins		   = {};
-		vec2					 pos			   = {};
-		vec2					 size			   = {};
-		vec2					 final_pos		   = {};
-		vec2					 final_size		   = {};
-		vec2					 scroll_offset	   = {};
-		unsigned int			 flags			   = 0;
-		float					 spacing		   = 0.0f;
 		bool					 receive_input	   = false;
 	};
 
+	////////////////////////////////////////////////////////////////////////////////
+	// :: LAYOUT ARENA
+	////////////////////////////////////////////////////////////////////////////////
+
+	enum layout_state : unsigned char
+	{
+		ls_dirty	   = 1 << 0,
+		ls_child_dirty = 1 << 1,
+		ls_visited	   = 1 << 2,
+		ls_sized	   = 1 << 3,
+		ls_positioned  = 1 << 4,
+		ls_size_all	   = 1 << 5,
+		ls_pos_pending = 1 << 6,
+		ls_bounds	   = 1 << 7,
+	};
+
+	enum layout_hook : unsigned char
+	{
+		lh_text		   = 1 << 0,
+		lh_size_policy = 1 << 1,
+		lh_pos_policy  = 1 << 2,
+		lh_transform   = 1 << 3,
+	};
+
+	// What a widget's flags resolve to on each axis, layout runs the kernel specialized for the pair instead of testing flags one by one.
+	enum pos_kernel_axis : unsigned char
+	{
+		pka_none,
+		pka_absolute,
+		pka_start,
+		pka_center,
+		pka_end,
+		pka_count,
+	};
+
+	enum size_kernel_axis : unsigned char
+	{
+		ska_none,
+		ska_absolute,
+		ska_relative,
+		ska_copy,
+		ska_count,
+	};
+
+	// Axis along which a row or column container's child bounds advance monotonically, so the children overlapping a span are found by binary search.
+	enum sorted_axis : unsigned char
+	{
+		sa_none,
+		sa_x,
+		sa_y,
+	};
+
+	// Inputs of a widget's last text measurement or size policy call, its result is reused while they match.
+	struct measure_cache
+	{
+		unsigned int revision  = 0;
+		vec2		 available = {};
+		vec2		 base	   = {};
+		const font*	 fnt	   = nullptr;
+		float		 scale	   = 0.0f;
+		vec2		 size	   = {};
+	};
+
+	// Line breaks of a wrap container, kept between builds so a child changing size only breaks the lines from its own on again.
+	struct wrap_lines
+	{
+		pod_vector<vec2>		 sizes;
+		pod_vector<unsigned int> starts;
+		pod_vector<float>		 heights;
+		unsigned int			 revision = 0;
+		float					 width	  = 0.0f;
+	};
+
+	// Column and row tracks of a grid container, resolved once per grid from its cells. Offsets are where each track starts inside the content area.
+	struct grid_tracks
+	{
+		pod_vector<float> widths;
+		pod_vector<float> heights;
+		pod_vector<float> column_offsets;
+		pod_vector<float> row_offsets;
+		vec2			  extent = {};
+	};
+
+	// Layout inputs and outputs of every widget as parallel arrays, so layout walks a few tightly packed floats instead of whole widgets.
+	// Entries are kept in depth-first order of the root's subtree (every subtree is a contiguous range), widgets find theirs through their pool slot.
+	class layout_arena
+	{
+	public:
+		static constexpr unsigned int no_entry = 0xFFFFFFFF;
+
+		void		 init(unsigned int capacity);
+		void		 uninit();
+		unsigned int add(unsigned int slot);
+		void		 reorder(const pod_vector<unsigned int>& slots, const pod_vector<unsigned int>& parents);
+		void		 set_wrap(unsigned int i, bool enabled);
+		void		 set_grid(unsigned int i, bool enabled);
+		void		 resolve_kernels(unsigned int i);
+		void		 mark_bounds(unsigned int i);
+
+		inline unsigned int get_entry(unsigned int slot) const { return _entries[slot]; }
+		inline unsigned int get_count() const { return _count; }
+		inline bool			get_is_full() const { return _count == _capacity; }
+
+		pod_vector<vec2>			  pos;
+		pod_vector<vec2>			  size;
+		pod_vector<unsigned int>	  flags;
+		pod_vector<vekt::margins>	  margins;
+		pod_vector<float>			  spacing;
+		pod_vector<vec2>			  final_pos;
+		pod_vector<vec2>			  final_size;
+		pod_vector<vec2>			  scroll_offset;
+		pod_vector<vec2>			  grow;
+		pod_vector<vec2>			  shrink;
+		pod_vector<vec2>			  min_size;
+		pod_vector<vec2>			  max_size;
+		pod_vector<child_positioning> positioning;
+		pod_vector<unsigned char>	  hooks;
+		pod_vector<unsigned char>	  pos_kernel;
+		pod_vector<unsigned char>	  size_kernel;
+		pod_vector<unsigned short>	  size_policy;
+		pod_vector<unsigned short>	  pos_policy;
+		pod_vector<unsigned char>	  state;
+		pod_vector<vec2>			  prev_pos;
+		pod_vector<vec2>			  prev_size;
+		pod_vector<vec4>			  bounds;
+		pod_vector<unsigned char>	  sorted_axis;
+		pod_vector<unsigned int>	  revision;
+		pod_vector<measure_cache>	  measures;
+		pod_vector<unsigned int>	  wrap;
+		pod_vector<wrap_lines>		  wraps;
+		pod_vector<unsigned int>	  grid;
+		pod_vector<grid_tracks>		  grids;
+		pod_vector<unsigned int>	  grid_columns;
+
+		pod_vector<unsigned int> slot;
+		pod_vector<unsigned int> parent;
+		pod_vector<unsigned int> subtree_end;
+
+		pod_vector<widget*>		  roots;
+		pod_vector<unsigned int>  bounds_pending;
+		bool					  order_dirty = true;
+		bool					  bounds_all  = true;
+		bool					  redraw	  = true;
+
+	private:
+		template <typename T>
+		void gather(pod_vector<T>& field, const pod_vector<unsigned int>& from);
+
+		template <typename T>
+		unsigned int set_cache(pod_vector<unsigned int>& index, pod_vector<T>& caches, pod_vector<unsigned int>& free_caches, unsigned int i, bool enabled);
+
+		pod_vector<unsigned int>  _entries;
+		pod_vector<unsigned int>  _free_wraps;
+		pod_vector<unsigned int>  _free_grids;
+		pod_vector<unsigned int>  _reuse_from;
+		pod_vector<unsigned char> _reuse_scratch;
+		unsigned int			  _count	= 0;
+		unsigned int			  _capacity = 0;
+	};
+
 	class widget
 	{
 	public:
@@ -871,18 +1224,88 @@ namespace vekt
 		void remove_child(widget* w);
 		void set_visible(bool is_visible, bool recursive);
 
+		// Flags this widget for re-layout in the next build and drops its cached measurement. Setters call this, call it manually after editing layout fields through get_data_widget()
+		// or when state read by its size policy changes.
+		void mark_layout_dirty();
+
+		// Makes the next build tessellate again instead of reporting no change. Setters, layout changes and the mutable gfx accessors call this, call it manually
+		// when a reference to draw data kept from an earlier accessor call is edited later.
+		inline void mark_redraw() { _arena->redraw = true; }
+
+		inline void set_margins(const margins& m)
+		{
+			_arena->margins[get_layout_index()] = m;
+			mark_layout_dirty();
+		}
+
+		inline void set_spacing(float spacing)
+		{
+			_arena->spacing[get_layout_index()] = spacing;
+			mark_layout_dirty();
+		}
+
+		inline void set_child_positioning(child_positioning positioning)
+		{
+			const unsigned int i = get_layout_index();
+			_arena->positioning[i] = positioning;
+			_arena->set_wrap(i, positioning == child_positioning::wrap);
+			_arena->set_grid(i, positioning == child_positioning::grid);
+			mark_layout_dirty();
+		}
+
+		// Cells of a grid container fill it row by row, this many per row.
+		inline void set_grid_columns(unsigned int columns)
+		{
+			_arena->grid_columns[get_layout_index()] = columns > 0 ? columns : 1;
+			mark_layout_dirty();
+		}
+
+		inline void set_scroll_offset(const vec2& offset)
+		{
+			_arena->scroll_offset[get_layout_index()] = offset;
+			mark_layout_dirty();
+		}
+
+		// Fill children share their parent's free space in proportion to grow. When siblings overflow the parent, children with a shrink weight give up space in proportion to weight times size.
+		inline void set_grow(const vec2& grow)
+		{
+			_arena->grow[get_layout_index()] = grow;
+			mark_layout_dirty();
+		}
+
+		inline void set_shrink(const vec2& shrink)
+		{
+			_arena->shrink[get_layout_index()] = shrink;
+			mark_layout_dirty();
+		}
+
+		// Bounds of the resolved size, min wins when they cross.
+		inline void set_min_size(const vec2& size)
+		{
+			_arena->min_size[get_layout_index()] = size;
+			mark_layout_dirty();
+		}
+
+		inline void set_max_size(const vec2& size)
+		{
+			_arena->max_size[get_layout_index()] = size;
+			mark_layout_dirty();
+		}
+
 		inline void set_pos_x(float x, helper_pos_type type = helper_pos_type::relative, helper_anchor_type anchor = helper_anchor_type::start)
 		{
-			_widget_data.pos.x = x;
-			_widget_data.flags &= ~(widget_flags::wf_pos_x_relative | widget_flags::wf_pos_x_absolute | widget_flags::wf_pos_anchor_x_center | widget_flags::wf_pos_anchor_x_end);
+			const unsigned int i	 = get_layout_index();
+			unsigned int&	   flags = _arena->flags[i];
+			_arena->pos[i].x = x;
+			flags &= ~(widget_flags::wf_pos_x_relative | widget_flags::wf_pos_x_absolute | widget_flags::wf_pos_anchor_x_center | widget_flags::wf_pos_anchor_x_end);
 
 			switch (type)
 			{
 			case helper_pos_type::relative:
-				_widget_data.flags |= widget_flags::wf_pos_x_relative;
+				flags |= widget_flags::wf_pos_x_relative;
 				break;
 			case helper_pos_type::absolute:
-				_widget_data.flags |= widget_flags::wf_pos_x_absolute;
+				flags |= widget_flags::wf_pos_x_absolute;
 				break;
 			default:
 				break;
@@ -891,28 +1314,33 @@ namespace vekt
 			switch (anchor)
 			{
 			case helper_anchor_type::center:
-				_widget_data.flags |= widget_flags::wf_pos_anchor_x_center;
+				flags |= widget_flags::wf_pos_anchor_x_center;
 				break;
 			case helper_anchor_type::end:
-				_widget_data.flags |= widget_flags::wf_pos_anchor_x_end;
+				flags |= widget_flags::wf_pos_anchor_x_end;
 				break;
 			default:
 				break;
 			}
+
+			_arena->resolve_kernels(i);
+			mark_layout_dirty();
 		}
 
 		inline void set_pos_y(float y, helper_pos_type type = helper_pos_type::relative, helper_anchor_type anchor = helper_anchor_type::start)
 		{
-			_widget_data.pos.y = y;
-			_widget_data.flags &= ~(widget_flags::wf_pos_y_relative | widget_flags::wf_pos_y_absolute | widget_flags::wf_pos_anchor_y_center | widget_flags::wf_pos_anchor_y_end);
+			const unsigned int i	 = get_layout_index();
+			unsigned int&	   flags = _arena->flags[i];
+			_arena->pos[i].y = y;
+			flags &= ~(widget_flags::wf_pos_y_relative | widget_flags::wf_pos_y_absolute | widget_flags::wf_pos_anchor_y_center | widget_flags::wf_pos_anchor_y_end);
 
 			switch (type)
 			{
 			case helper_pos_type::relative:
-				_widget_data.flags |= widget_flags::wf_pos_y_relative;
+				flags |= widget_flags::wf_pos_y_relative;
 				break;
 			case helper_pos_type::absolute:
-				_widget_data.flags |= widget_flags::wf_pos_y_absolute;
+				flags |= widget_flags::wf_pos_y_absolute;
 				break;
 			default:
 				break;
@@ -921,115 +1349,170 @@ namespace vekt
 			switch (anchor)
 			{
 			case helper_anchor_type::center:
-				_widget_data.flags |= widget_flags::wf_pos_anchor_y_center;
+				flags |= widget_flags::wf_pos_anchor_y_center;
 				break;
 			case helper_anchor_type::end:
-				_widget_data.flags |= widget_flags::wf_pos_anchor_y_end;
+				flags |= widget_flags::wf_pos_anchor_y_end;
 				break;
 			default:
 				break;
 			}
+
+			_arena->resolve_kernels(i);
+			mark_layout_dirty();
 		}
 
 		inline void set_width(float width, helper_size_type type = helper_size_type::relative)
 		{
-			_widget_data.size.x = width;
-			_widget_data.flags &= ~(widget_flags::wf_size_x_absolute | widget_flags::wf_size_x_relative | widget_flags::wf_size_x_fill | widget_flags::wf_size_x_copy_y | widget_flags::wf_size_x_max_children | widget_flags::wf_size_x_total_children);
+			const unsigned int i	 = get_layout_index();
+			unsigned int&	   flags = _arena->flags[i];
+			_arena->size[i].x = width;
+			flags &= ~(widget_flags::wf_size_x_absolute | widget_flags::wf_size_x_relative | widget_flags::wf_size_x_fill | widget_flags::wf_size_x_copy_y | widget_flags::wf_size_x_max_children | widget_flags::wf_size_x_total_children);
 
 			switch (type)
 			{
 			case helper_size_type::absolute:
-				_widget_data.flags |= widget_flags::wf_size_x_absolute;
+				flags |= widget_flags::wf_size_x_absolute;
 				break;
 			case helper_size_type::relative:
-				_widget_data.flags |= widget_flags::wf_size_x_relative;
+				flags |= widget_flags::wf_size_x_relative;
 				break;
 			case helper_size_type::fill:
-				_widget_data.flags |= widget_flags::wf_size_x_fill;
+				flags |= widget_flags::wf_size_x_fill;
 				break;
 			case helper_size_type::max_children:
-				_widget_data.flags |= widget_flags::wf_size_x_max_children;
+				flags |= widget_flags::wf_size_x_max_children;
 				break;
 			case helper_size_type::total_children:
-				_widget_data.flags |= widget_flags::wf_size_x_total_children;
+				flags |= widget_flags::wf_size_x_total_children;
 				break;
 			case helper_size_type::copy_other:
-				_widget_data.flags |= widget_flags::wf_size_x_copy_y;
+				flags |= widget_flags::wf_size_x_copy_y;
 				break;
 			default:
 				break;
 			}
+
+			_arena->resolve_kernels(i);
+			mark_layout_dirty();
 		}
 
 		inline void set_height(float height, helper_size_type type = helper_size_type::relative)
 		{
-			_widget_data.size.y = height;
-			_widget_data.flags &= ~(widget_flags::wf_size_y_absolute | widget_flags::wf_size_y_relative | widget_flags::wf_size_y_fill | widget_flags::wf_size_y_copy_x | widget_flags::wf_size_y_max_children | widget_flags::wf_size_y_total_children);
+			const unsigned int i	 = get_layout_index();
+			unsigned int&	   flags = _arena->flags[i];
+			_arena->size[i].y = height;
+			flags &= ~(widget_flags::wf_size_y_absolute | widget_flags::wf_size_y_relative | widget_flags::wf_size_y_fill | widget_flags::wf_size_y_copy_x | widget_flags::wf_size_y_max_children | widget_flags::wf_size_y_total_children);
 
 			switch (type)
 			{
 			case helper_size_type::absolute:
-				_widget_data.flags |= widget_flags::wf_size_y_absolute;
+				flags |= widget_flags::wf_size_y_absolute;
 				break;
 			case helper_size_type::relative:
-				_widget_data.flags |= widget_flags::wf_size_y_relative;
+				flags |= widget_flags::wf_size_y_relative;
 				break;
 			case helper_size_type::fill:
-				_widget_data.flags |= widget_flags::wf_size_y_fill;
+				flags |= widget_flags::wf_size_y_fill;
 				break;
 			case helper_size_type::max_children:
-				_widget_data.flags |= widget_flags::wf_size_y_max_children;
+				flags |= widget_flags::wf_size_y_max_children;
 				break;
 			case helper_size_type::total_children:
-				_widget_data.flags |= widget_flags::wf_size_y_total_children;
+				flags |= widget_flags::wf_size_y_total_children;
 				break;
 			case helper_size_type::copy_other:
-				_widget_data.flags |= widget_flags::wf_size_y_copy_x;
+				flags |= widget_flags::wf_size_y_copy_x;
 				break;
 			default:
 				break;
 			}
+
+			_arena->resolve_kernels(i);
+			mark_layout_dirty();
+		}
+
+		inline void set_draw_order(bool draw_order)
+		{
+			_widget_gfx.draw_order = draw_order;
+			mark_redraw();
 		}
 
-		inline void				set_draw_order(bool draw_order) { _widget_gfx.draw_order = draw_order; }
-		inline bool				get_is_visible() const { return !(_widget_data.flags & widget_flags::wf_invisible); }
+		void					set_transform(const widget_transform& transform);
+		inline const widget_transform& get_transform() const { return _widget_gfx.transform; }
+
+		// Multiplies the alpha of this widget and its whole subtree at draw time, subtrees at 0 are neither drawn nor hit.
+		inline void set_opacity(float opacity)
+		{
+			_widget_gfx.opacity = math::clamp(opacity, 0.0f, 1.0f);
+			mark_redraw();
+		}
+
+		inline float			get_opacity() const { return _widget_gfx.opacity; }
+		inline bool				get_is_visible() const { return !(get_flags() & widget_flags::wf_invisible); }
 		inline widget_data&		get_data_widget() { return _widget_data; }
-		inline widget_gfx&		get_gfx_data() { return _widget_gfx; }
+		inline bool				get_is_hovered() const { return _is_hovered; };
+		inline bool				get_is_pressed() const { return _press_states[0]; }
+
+		// Handing out mutable draw data counts as a change, the caller is about to edit what the next build draws.
+		inline widget_gfx& get_gfx_data()
+		{
+			mark_redraw();
+			return _widget_gfx;
+		}
+
 		inline gfx_text&		get_gfx_text() { return set_gfx_type_text(); }
 		inline gfx_filled_rect& get_gfx_filled_rect() { return set_gfx_type_filled_rect(); }
 		inline gfx_stroke_rect& get_gfx_stroke_rect() { return set_gfx_type_stroke_rect(); }
-		inline bool				get_is_hovered() const { return _is_hovered; };
-		inline bool				get_is_pressed() const { return _press_states[0]; }
 
-		inline void set_gfx_type_none() { _widget_gfx.type = gfx_type::none; }
+		inline void set_gfx_type_none()
+		{
+			if (_widget_gfx.type == gfx_type::none) return;
+			_widget_gfx.type = gfx_type::none;
+			mark_redraw();
+			_arena->hooks[get_layout_index()] &= ~layout_hook::lh_text;
+			mark_layout_dirty();
+		}
 
 		inline gfx_text& set_gfx_type_text()
 		{
+			mark_redraw();
 			if (_widget_gfx.type == gfx_type::_text) return std::get<gfx_text>(_widget_gfx.gfx);
 			_widget_gfx.gfx	 = gfx_text();
 			_widget_gfx.type = gfx_type::_text;
+			std::get<gfx_text>(_widget_gfx.gfx)._widget = this;
+			_arena->hooks[get_layout_index()] |= layout_hook::lh_text;
+			mark_layout_dirty();
 			return std::get<gfx_text>(_widget_gfx.gfx);
 		}
 
 		inline gfx_filled_rect& set_gfx_type_filled_rect()
 		{
+			mark_redraw();
 			if (_widget_gfx.type == gfx_type::filled_rect) return std::get<gfx_filled_rect>(_widget_gfx.gfx);
 			_widget_gfx.gfx	 = gfx_filled_rect();
 			_widget_gfx.type = gfx_type::filled_rect;
+			_arena->hooks[get_layout_index()] &= ~layout_hook::lh_text;
+			mark_layout_dirty();
 			return std::get<gfx_filled_rect>(_widget_gfx.gfx);
 		}
 
 		inline gfx_stroke_rect& set_gfx_type_stroke_rect()
 		{
+			mark_redraw();
 			if (_widget_gfx.type == gfx_type::stroke_rect) return std::get<gfx_stroke_rect>(_widget_gfx.gfx);
 			_widget_gfx.gfx	 = gfx_stroke_rect();
 			_widget_gfx.type = gfx_type::stroke_rect;
+			_arena->hooks[get_layout_index()] &= ~layout_hook::lh_text;
+			mark_layout_dirty();
 			return std::get<gfx_stroke_rect>(_widget_gfx.gfx);
 		}
 
 		inline bool is_point_in_bounds(unsigned int x, unsigned int y)
 		{
-			return x >= _widget_data.final_pos.x && x <= _widget_data.final_pos.x + _widget_data.final_size.x && y >= _widget_data.final_pos.y && y <= _widget_data.final_pos.y + _widget_data.final_size.y;
+			const vec2& pos	 = get_final_pos();
+			const vec2& size = get_final_size();
+			return x >= pos.x && x <= pos.x + size.x && y >= pos.y && y <= pos.y + size.y;
 		}
 
 		template <typename T>
@@ -1039,16 +1522,74 @@ namespace vekt
 			return reinterpret_cast<T*>(_user_data);
 		}
 
-		inline vec4 get_clip_rect() const { return {_widget_data.final_pos.x, _widget_data.final_pos.y, _widget_data.final_size.x, _widget_data.final_size.y}; }
+		// Local transform resolved around the widget's current center, relative to its parent's space.
+		inline affine get_transform_matrix() const
+		{
+			const widget_transform& t = _widget_gfx.transform;
+			return affine::make(t.translation, t.scale, t.rotation, get_final_pos() + get_final_size() * 0.5f);
+		}
+
+		inline vec4 get_clip_rect() const
+		{
+			const vec2& pos	 = get_final_pos();
+			const vec2& size = get_final_size();
+			return {pos.x, pos.y, size.x, size.y};
+		}
+
+		inline const vec2&		 get_pos() const { return _arena->pos[get_layout_index()]; }
+		inline const vec2&		 get_size() const { return _arena->size[get_layout_index()]; }
+		inline unsigned int		 get_flags() const { return _arena->flags[get_layout_index()]; }
+		inline const margins&	 get_margins() const { return _arena->margins[get_layout_index()]; }
+		inline float			 get_spacing() const { return _arena->spacing[get_layout_index()]; }
+		inline child_positioning get_child_positioning() const { return _arena->positioning[get_layout_index()]; }
+		inline unsigned int		 get_grid_columns() const { return _arena->grid_columns[get_layout_index()]; }
+		inline const vec2&		 get_scroll_offset() const { return _arena->scroll_offset[get_layout_index()]; }
+		inline const vec2&		 get_grow() const { return _arena->grow[get_layout_index()]; }
+		inline const vec2&		 get_shrink() const { return _arena->shrink[get_layout_index()]; }
+		inline const vec2&		 get_min_size() const { return _arena->min_size[get_layout_index()]; }
+		inline const vec2&		 get_max_size() const { return _arena->max_size[get_layout_index()]; }
+		inline const vec2&		 get_final_pos() const { return _arena->final_pos[get_layout_index()]; }
+		inline const vec2&		 get_final_size() const { return _arena->final_size[get_layout_index()]; }
+
+		// Meant for layout policies, layout overwrites these on the next pass that visits the widget.
+		inline void set_final_pos(const vec2& pos) { _arena->final_pos[get_layout_index()] = pos; }
+		inline void set_final_size(const vec2& size) { _arena->final_size[get_layout_index()] = size; }
+
+		// Registered policies run right after the widget's own size or position pass, id 0 removes them.
+		inline void set_pos_policy(unsigned short id)
+		{
+			const unsigned int i = get_layout_index();
+			if (id) _arena->hooks[i] |= layout_hook::lh_pos_policy;
+			else _arena->hooks[i] &= ~layout_hook::lh_pos_policy;
+			_arena->pos_policy[i] = id;
+			mark_layout_dirty();
+		}
+
+		inline void set_size_policy(unsigned short id)
+		{
+			const unsigned int i = get_layout_index();
+			if (id) _arena->hooks[i] |= layout_hook::lh_size_policy;
+			else _arena->hooks[i] &= ~layout_hook::lh_size_policy;
+			_arena->size_policy[i] = id;
+			mark_layout_dirty();
+		}
+
+		inline unsigned short get_pos_policy() const { return _arena->pos_policy[get_layout_index()]; }
+		inline unsigned short get_size_policy() const { return _arena->size_policy[get_layout_index()]; }
+
+		inline bool get_is_layout_dirty() const { return _arena->state[get_layout_index()] & (layout_state::ls_dirty | layout_state::ls_child_dirty); }
+
+		// A relayout boundary's final size can not depend on its descendants, so their invalidation never needs to climb past it.
+		inline bool get_is_layout_boundary() const
+		{
+			const unsigned int i = get_layout_index();
+			return !(_arena->flags[i] & (widget_flags::wf_size_x_max_children | widget_flags::wf_size_x_total_children | widget_flags::wf_size_y_max_children | widget_flags::wf_size_y_total_children)) && !(_arena->hooks[i] & layout_hook::lh_size_policy);
+		}
 
 	private:
-		void size_pass();
-		void size_pass_children(pod_vector<widget*>& fill_x, pod_vector<widget*>& fill_y);
-		void size_pass_post(pod_vector<widget*>& fill_x, pod_vector<widget*>& fill_y);
-		void size_copy_check();
-		void pos_pass();
-		void pos_pass_children();
-		void pos_pass_post();
+		inline unsigned int get_layout_index() const { return _arena->get_entry(_pool_handle.value); }
+		void				mark_layout_pending();
+
 		bool draw_pass_clip_check(class builder& builder);
 		void draw_pass_clip_check_end(class builder& builder);
 		void draw_pass(class builder& builder);
@@ -1122,6 +1663,7 @@ namespace vekt
 		friend class builder;
 
 		handle		  _pool_handle = {};
+		layout_arena* _arena	   = nullptr;
 		widget_data	  _widget_data = {};
 		widget_gfx	  _widget_gfx  = {};
 		unsigned char _user_data[VEKT_USER_DATA_SIZE];
@@ -1129,6 +1671,30 @@ namespace vekt
 		bool		  _press_states[3] = {false};
 	};
 
+	inline void gfx_text::set_text(const VEKT_STRING& txt)
+	{
+		_text = txt;
+		if (_widget) _widget->mark_layout_dirty();
+	}
+
+	inline void gfx_text::set_font(font* fnt)
+	{
+		_font = fnt;
+		if (_widget) _widget->mark_layout_dirty();
+	}
+
+	inline void gfx_text::set_scale(float s)
+	{
+		_scale = s;
+		if (_widget) _widget->mark_layout_dirty();
+	}
+
+	inline void gfx_text::set_parent_relative_scale(float f)
+	{
+		_parent_relative_scale = f;
+		if (_widget) _widget->mark_layout_dirty();
+	}
+
 	typedef std::function<void(widget*, bool)> on_bool_changed;
 
 	struct checkbox_data
@@ -1158,58 +1724,241 @@ namespace vekt
 
 	typedef unsigned short index;
 
-	////////////////////////////////////////////////////////////////////////////////
-	// :: BUILDER
-	////////////////////////////////////////////////////////////////////////////////
-
-	struct draw_buffer
+	// Everything a rect's tessellation depends on besides its position, so geometry generated for a widget is reused while they match.
+	struct tessellation_key
 	{
-		void*		 user_data	   = nullptr;
-		font*		 used_font	   = nullptr;
-		vec4		 clip		   = vec4();
-		vertex*		 vertex_start  = nullptr;
-		index*		 index_start   = nullptr;
-		unsigned int draw_order	   = 0;
-		unsigned int vertex_count  = 0;
-		unsigned int index_count   = 0;
-		unsigned int _max_vertices = 0;
-		unsigned int _max_indices  = 0;
+		gfx_type	 type			   = gfx_type::none;
+		vec2		 size			   = {};
+		vec4		 color_start	   = {};
+		vec4		 color_end		   = {};
+		vec4		 outline_color	   = {};
+		float		 rounding		   = 0.0f;
+		unsigned int segments		   = 0;
+		unsigned int thickness		   = 0;
+		unsigned int outline_thickness = 0;
+		unsigned int aa_thickness	   = 0;
+		direction	 color_direction   = direction::horizontal;
 
-		inline void add_vertex(const vertex& vtx)
+		bool operator==(const tessellation_key& o) const
 		{
-			ASSERT(vertex_count < _max_vertices);
-			vertex_start[vertex_count] = vtx;
-			vertex_count++;
+			return type == o.type && size == o.size && color_start == o.color_start && color_end == o.color_end && outline_color == o.outline_color && rounding == o.rounding && segments == o.segments &&
+				   thickness == o.thickness && outline_thickness == o.outline_thickness && aa_thickness == o.aa_thickness && color_direction == o.color_direction;
 		}
+	};
 
-		inline vertex& add_get_vertex()
-		{
-			ASSERT(vertex_count < _max_vertices);
-			const unsigned int idx = vertex_count;
-			vertex_count++;
-			return vertex_start[idx];
-		}
+	// Vertices relative to the rect's min and indices relative to its first vertex, untransformed and at full opacity.
+	struct tessellation_cache
+	{
+		tessellation_key   key;
+		pod_vector<vertex> vertices;
+		pod_vector<index>  indices;
+	};
 
-		inline void add_index(index idx)
-		{
-			ASSERT(index_count < _max_indices);
-			index_start[index_count] = idx;
-			index_count++;
-		}
+	enum class output_mode
+	{
+		triangles,
+		rect_instances
 	};
 
-	typedef std::function<void(const draw_buffer& db)> draw_callback;
+	// One filled or stroke rect in output_mode::rect_instances, for renderers that shade a rounded box distance field per pixel instead of drawing triangles.
+	// rect is x, y, width, height before transform, colors already carry the widget's opacity.
+	// Filled rects draw their outline outside the rect, strokes a band of thickness inside it, the aa fringe fades out beyond both edges.
+	struct rect_instance
+	{
+		vec4		 rect			   = {};
+		vec4		 color_start	   = {};
+		vec4		 color_end		   = {};
+		vec4		 outline_color	   = {};
+		affine		 transform		   = {};
+		float		 rounding		   = 0.0f;
+		float		 thickness		   = 0.0f;
+		float		 outline_thickness = 0.0f;
+		float		 aa_thickness	   = 0.0f;
+		unsigned int color_direction   = 0;
+		unsigned int is_stroke		   = 0;
+
+		// Reference for shaders, straight alpha color at screen position p.
+		vec4 evaluate(const vec2& p) const;
+	};
 
-	class theme
+	// Hands out power of two sized spans carved from chunks allocated on demand, freed spans are kept per size for reuse.
+	template <typename T>
+	class span_arena
 	{
 	public:
-		static vec4	 color_item_bg;
-		static vec4	 color_item_hover;
-		static vec4	 color_item_press;
-		static vec4	 color_panel_bg;
-		static vec4	 color_divider;
-		static vec4	 color_item_outline;
-		static vec4	 color_item_fg;
+		static constexpr unsigned int min_span	 = 64;
+		static constexpr unsigned int class_count = 32;
+
+		~span_arena() { uninit(); }
+
+		void init(size_t chunk_size) { _chunk_size = chunk_size > min_span ? chunk_size : min_span; }
+
+		void uninit()
+		{
+			for (chunk& c : _chunks)
+				FREE(c.data);
+			_chunks.clear();
+			for (pod_vector<T*>& f : _free)
+				f.clear();
+			_reserved = 0;
+		}
+
+		// Capacity is rounded up to the span actually handed out.
+		T* allocate(unsigned int& capacity)
+		{
+			unsigned int cls  = 0;
+			unsigned int size = min_span;
+			while (size < capacity)
+			{
+				size <<= 1;
+				cls++;
+			}
+			ASSERT(cls < class_count);
+			capacity = size;
+
+			pod_vector<T*>& free_list = _free[cls];
+			if (!free_list.empty())
+			{
+				T* ptr = free_list[free_list.size() - 1];
+				free_list.remove(free_list.size() - 1);
+				return ptr;
+			}
+
+			if (_chunks.empty() || _chunks.get_back().head + size > _chunks.get_back().size)
+			{
+				const size_t chunk_size = _chunk_size > size ? _chunk_size : size;
+				T*			 data		= reinterpret_cast<T*>(MALLOC(sizeof(T) * chunk_size));
+				if (!data) throw std::bad_alloc();
+				_chunks.push_back({data, chunk_size, 0});
+				_reserved += sizeof(T) * chunk_size;
+			}
+
+			chunk& c   = _chunks.get_back();
+			T*	   ptr = c.data + c.head;
+			c.head += size;
+			return ptr;
+		}
+
+		void free(T* ptr, unsigned int capacity)
+		{
+			if (!ptr) return;
+			unsigned int cls = 0;
+			for (unsigned int size = min_span; size < capacity; size <<= 1)
+				cls++;
+			_free[cls].push_back(ptr);
+		}
+
+		inline size_t get_reserved() const { return _reserved; }
+
+	private:
+		struct chunk
+		{
+			T*	   data;
+			size_t size;
+			size_t head;
+		};
+
+		pod_vector<chunk> _chunks;
+		pod_vector<T*>	  _free[class_count];
+		size_t			  _chunk_size = 0;
+		size_t			  _reserved	  = 0;
+	};
+
+	struct draw_arenas
+	{
+		span_arena<vertex>		  vertices;
+		span_arena<index>		  indices;
+		span_arena<rect_instance> instances;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	// :: BUILDER
+	////////////////////////////////////////////////////////////////////////////////
+
+	struct draw_buffer
+	{
+		void*		 user_data	   = nullptr;
+		font*		 used_font	   = nullptr;
+		vec4		 clip		   = vec4();
+		vertex*		 vertex_start  = nullptr;
+		index*		 index_start   = nullptr;
+		unsigned int draw_order	   = 0;
+		unsigned int viewport	   = 0;
+		unsigned int vertex_count  = 0;
+		unsigned int index_count   = 0;
+		unsigned int _max_vertices = 0;
+		unsigned int _max_indices  = 0;
+		draw_arenas* _arenas	   = nullptr;
+
+		rect_instance* instance_start  = nullptr;
+		unsigned int   instance_count  = 0;
+		unsigned int   _max_instances  = 0;
+
+		// Spans grow on demand and move when they do, pointers and references into them are only valid until the next add.
+		inline void add_vertex(const vertex& vtx)
+		{
+			if (vertex_count == _max_vertices) grow_vertices(vertex_count + 1);
+			vertex_start[vertex_count] = vtx;
+			vertex_count++;
+		}
+
+		inline vertex& add_get_vertex()
+		{
+			if (vertex_count == _max_vertices) grow_vertices(vertex_count + 1);
+			const unsigned int idx = vertex_count;
+			vertex_count++;
+			return vertex_start[idx];
+		}
+
+		inline vertex* add_get_vertices(unsigned int count)
+		{
+			if (vertex_count + count > _max_vertices) grow_vertices(vertex_count + count);
+			const unsigned int idx = vertex_count;
+			vertex_count += count;
+			return vertex_start + idx;
+		}
+
+		inline void add_index(index idx)
+		{
+			if (index_count == _max_indices) grow_indices(index_count + 1);
+			index_start[index_count] = idx;
+			index_count++;
+		}
+
+		inline index* add_get_indices(unsigned int count)
+		{
+			if (index_count + count > _max_indices) grow_indices(index_count + count);
+			const unsigned int idx = index_count;
+			index_count += count;
+			return index_start + idx;
+		}
+
+		inline rect_instance& add_get_instance()
+		{
+			if (instance_count == _max_instances) grow_instances(instance_count + 1);
+			const unsigned int idx = instance_count;
+			instance_count++;
+			return instance_start[idx];
+		}
+
+		void grow_vertices(unsigned int count);
+		void grow_indices(unsigned int count);
+		void grow_instances(unsigned int count);
+		void release();
+	};
+
+	typedef std::function<void(const draw_buffer& db)> draw_callback;
+
+	class theme
+	{
+	public:
+		static vec4	 color_item_bg;
+		static vec4	 color_item_hover;
+		static vec4	 color_item_press;
+		static vec4	 color_panel_bg;
+		static vec4	 color_divider;
+		static vec4	 color_item_outline;
+		static vec4	 color_item_fg;
 		static float item_height;
 		static float item_spacing;
 		static float indent_horizontal;
@@ -1231,10 +1980,51 @@ namespace vekt
 
 		struct init_config
 		{
+			// Vertex, index and instance sizes are the chunk size their arenas grow by, draw buffers take spans out of the chunks as they fill up.
+			// buffer_count is only a hint for the initial draw buffer list, there is no limit.
 			size_t widget_buffer_sz = 1024 * 1024;
 			size_t vertex_buffer_sz = 1024 * 1024;
 			size_t index_buffer_sz	= 1024 * 1024;
 			size_t buffer_count		= 10;
+			size_t instance_buffer_sz = 0;
+
+			// Threads sharing layout, including the one calling build(). Subtrees with at least layout_task_min_entries widgets are handed to the pool.
+			// Layout policies of such subtrees run on workers and must only touch their own widget.
+			unsigned int layout_thread_count	 = 1;
+			unsigned int layout_task_min_entries = 512;
+		};
+
+		// Whether the last build's output differs from the one before, and the earliest time passed to request_redraw() still ahead (DBL_MAX for none), in the host's own clock.
+		// Hosts can skip flush() when nothing changed and sleep until an input event or wake_time, animations and caret blinks request their next step.
+		struct build_result
+		{
+			bool   changed	 = false;
+			double wake_time = DBL_MAX;
+		};
+
+		struct viewport
+		{
+			widget*		 root	  = nullptr;
+			vec2		 size	  = {};
+			unsigned int tag	  = 0;
+			bool		 retained = false;
+		};
+
+		// Counters of the last build's layout. Measurements are text sizes and size policy calls, a hit reuses the cached result.
+		struct layout_stats
+		{
+			unsigned int measure_hits	= 0;
+			unsigned int measure_misses = 0;
+		};
+
+		// Largest counts a single draw buffer reached since init, and bytes the draw arenas hold.
+		struct draw_stats
+		{
+			unsigned int peak_vertices	 = 0;
+			unsigned int peak_indices	 = 0;
+			unsigned int peak_instances	 = 0;
+			unsigned int peak_buffers	 = 0;
+			size_t		 reserved_bytes = 0;
 		};
 
 		builder()					  = default;
@@ -1243,7 +2033,9 @@ namespace vekt
 
 		void			   init(const init_config& conf);
 		void			   uninit();
-		void			   build(const vec2& screen_size);
+		build_result	   build(const vec2& screen_size, double time = 0.0);
+		void			   request_redraw(double time);
+		void			   build_viewport(widget* root);
 		void			   flush();
 		void			   on_mouse_move(const vec2& mouse);
 		input_event_result on_mouse_event(const mouse_event& ev);
@@ -1251,8 +2043,9 @@ namespace vekt
 		input_event_result on_key_event(const key_event& ev);
 		void			   add_input_layer(unsigned int priority, widget* root);
 		void			   remove_input_layer(unsigned int priority);
-		void			   add_filled_rect(const gfx_filled_rect& rect, const vec2& min, const vec2& max, unsigned int draw_order, void* user_data, bool use_hovered, bool use_pressed);
-		void			   add_stroke_rect(const gfx_stroke_rect& rect, const vec2& min, const vec2& max, unsigned int draw_order, void* user_data, bool use_hovered, bool use_pressed);
+		unsigned short	   register_layout_policy(layout_policy_func func, void* context = nullptr, bool cacheable = false);
+		void add_filled_rect(const gfx_filled_rect& rect, const vec2& min, const vec2& max, unsigned int draw_order, void* user_data, bool use_hovered, bool use_pressed, tessellation_cache* cache = nullptr);
+		void add_stroke_rect(const gfx_stroke_rect& rect, const vec2& min, const vec2& max, unsigned int draw_order, void* user_data, bool use_hovered, bool use_pressed, tessellation_cache* cache = nullptr);
 		void			   add_text(const gfx_text& _text, const vec2& position, const vec2& size, unsigned int draw_order, void* user_data, bool use_hovered, bool use_pressed);
 		static vec2		   get_text_size(gfx_text& _text, const vec2& parent_size = vec2());
 		draw_buffer*	   get_draw_buffer(unsigned int draw_order, void* user_data, font* fnt = nullptr);
@@ -1268,14 +2061,45 @@ namespace vekt
 		widget* widget_button(font* fnt, const VEKT_STRING& _text);
 		widget* widget_checkbox(bool initial_value, void* sdf_material);
 
+		// Roots of other windows or world-space panels, built in the same pass and buffers as the main root. Their draw buffers carry tag as viewport, so tags should be unique.
+		// build() skips retained viewports and flush() keeps drawing their last buffers, build_viewport() lays out and tessellates one of them alone when it needs to update.
+		void add_viewport(widget* root, const vec2& size, unsigned int tag, bool retained = false);
+		void remove_viewport(widget* root);
+		void set_viewport_size(widget* root, const vec2& size);
+
 		inline vec4 get_current_clip() const { return _clip_stack.empty() ? vec4() : _clip_stack[_clip_stack.size() - 1]; }
-		inline void set_root(widget* root) { _root = root; }
+		inline void set_root(widget* root)
+		{
+			// The main root is always the first viewport, its size comes from build().
+			if (_viewports.empty()) _viewports.push_back({});
+			_viewports[0].root		  = root;
+			_root					  = root;
+			_layout_arena.order_dirty = true;
+		}
 		inline void set_on_draw(draw_callback cb) { _on_draw = cb; }
+		inline const layout_stats& get_layout_stats() const { return _layout_stats; }
+		inline const draw_stats&   get_draw_stats() const { return _draw_stats; }
+
+		// Max distance in pixels between a rounded corner and its tessellation, used for rects that leave segments at 0. 0 falls back to 10 segments per corner.
+		inline void	 set_tessellation_tolerance(float px) { _tessellation_tolerance = px; }
+		inline float get_tessellation_tolerance() const { return _tessellation_tolerance; }
+
+		// In rect_instances mode filled and stroke rects go to the draw buffers' instance stream as a single record each, text still emits triangles.
+		inline void set_output_mode(output_mode mode)
+		{
+			_output_mode		  = mode;
+			_layout_arena.redraw = true;
+		}
+		inline output_mode get_output_mode() const { return _output_mode; }
 
 		template <typename... Args>
 		widget* allocate(Args&&... args)
 		{
-			return _widget_pool.allocate(args...);
+			if (_layout_arena.get_is_full()) layout_order();
+			widget* w = _widget_pool.allocate(args...);
+			w->_arena = &_layout_arena;
+			_layout_arena.add(w->_pool_handle.value);
+			return w;
 		}
 
 		inline void deallocate(widget* w)
@@ -1283,6 +2107,16 @@ namespace vekt
 			pod_vector<widget*>::iterator it = _press_state_history.find(w);
 			if (it != _press_state_history.end()) { _press_state_history.remove(it); }
 
+			it = _hovered.find(w);
+			if (it != _hovered.end()) { _hovered.remove(it); }
+
+			it = _layout_arena.roots.find(w);
+			if (it != _layout_arena.roots.end()) { _layout_arena.roots.remove(it); }
+			remove_viewport(w);
+			_layout_arena.set_wrap(w->get_layout_index(), false);
+			_layout_arena.set_grid(w->get_layout_index(), false);
+			_layout_arena.order_dirty = true;
+
 			for (widget* c : w->_widget_data.children)
 				deallocate(c);
 
@@ -1291,6 +2125,7 @@ namespace vekt
 
 	private:
 		void	generate_rounded_rect(pod_vector<vec2>& out_path, const vec2& min, const vec2& max, float rounding, int segments);
+		int		get_corner_segments(const vec2& min, const vec2& max, float rounding, unsigned int segments) const;
 		void	generate_sharp_rect(pod_vector<vec2>& out_path, const vec2& min, const vec2& max);
 		void	generate_offset_rect(pod_vector<vec2>& out_path, const pod_vector<vec2>& base_path, float amount);
 		void	generate_offset_rounded_rect(pod_vector<vec2>& out_path, const pod_vector<vec2>& base_path, float amount);
@@ -1300,33 +2135,128 @@ namespace vekt
 		void	add_vertices(draw_buffer* db, const pod_vector<vec2>& path, const vec4& color_start, const vec4& color_end, direction direction, const vec2& min, const vec2& max);
 		void	add_central_vertex(draw_buffer* db, const vec4& color_start, const vec4& color_end, const vec2& min, const vec2& max);
 		void	add_vertices_aa(draw_buffer* db, const pod_vector<vec2>& path, unsigned int original_vertices_idx, float alpha, const vec2& min, const vec2& max);
+		bool	begin_cached(draw_buffer* db, tessellation_cache* cache, const tessellation_key& key, const vec2& min);
+		void	end_cached(draw_buffer* db, tessellation_cache* cache, const tessellation_key& key, const vec2& min, unsigned int vertex_start, unsigned int index_start);
+		void	add_cached(draw_buffer* db, const tessellation_cache& cache, const vec2& min);
+		void	add_rect_instance(draw_buffer* db, const vec2& min, const vec2& max, const vec4& color_start, const vec4& color_end, const vec4& outline_color, float rounding, float thickness, float outline_thickness, float aa_thickness, direction color_direction, bool is_stroke);
+		const pod_vector<index>& get_index_pattern(pod_vector<pod_vector<index>>& patterns, unsigned int size, bool fan, bool ccw);
 		widget* find_widget_at(widget* current_widget, const vec2& mouse);
 		void	pass_hover_state(widget* w, const vec2& mouse);
+		void	layout(const viewport* only);
+		void	layout_order();
+		void	layout_bounds();
+		void	build_viewports(const viewport* only);
+		void	release_draw_buffers(const viewport* only);
+		void	rebuild_draw_buffer_table();
+		bool	get_is_in_scope(unsigned int i, const viewport* only) const;
+		void	layout_bounds_entry(unsigned int i);
+		void	get_child_range(widget* w, float lo, float hi, unsigned int& first, unsigned int& last) const;
+		void	layout_order_append(widget* w, unsigned int parent);
+		void	layout_track(unsigned int i, unsigned int worker);
+		void	layout_size(unsigned int i, bool force, unsigned int worker);
+		void	layout_size_subtree(unsigned int i, bool force, unsigned int worker);
+		void	layout_size_children(unsigned int i, bool force, unsigned int worker);
+		void	layout_pos_children(unsigned int i, unsigned int worker);
+		void	size_pass(unsigned int i, unsigned int worker);
+		void	size_pass_post(unsigned int i, unsigned int worker);
+		void	size_copy_check(unsigned int i);
+		void	size_clamp(unsigned int i);
+		void	size_wrap(unsigned int i);
+		void	size_wrap_height(unsigned int i);
+		void	size_grid(unsigned int i);
+		void	size_apply(unsigned int i, unsigned int first, unsigned int worker);
+		void	size_flex(unsigned int i, float vec2::*axis, unsigned int fill_flag, float fixed, bool shrink, unsigned int first, unsigned int worker);
+		void	pos_pass(unsigned int i);
+		void	pos_pass_children(unsigned int i, unsigned int worker);
+
+		inline vec4 get_transformed_rect(const vec4& rect) const { return _transform.is_identity() ? rect : _transform.apply_rect(rect); }
+
+		static void layout_size_task(void* owner, unsigned int i, unsigned int worker);
+		static void layout_size_forced_task(void* owner, unsigned int i, unsigned int worker);
+		static void layout_pos_task(void* owner, unsigned int i, unsigned int worker);
 
 	private:
-		pool<widget>			_widget_pool;
-		pod_vector<vec4>		_clip_stack;
-		pod_vector<input_layer> _input_layers;
-		pod_vector<draw_buffer> _draw_buffers;
-		widget*					_root				 = nullptr;
-		draw_callback			_on_draw			 = nullptr;
-		pod_vector<widget*>		_press_state_history = {};
-		vec2					_mouse_position		 = {};
-
-		pod_vector<vec2>	_reuse_outer_path;
-		pod_vector<vec2>	_reuse_inner_path;
-		pod_vector<vec2>	_reuse_outline_path;
-		pod_vector<vec2>	_reuse_aa_outer_path;
-		pod_vector<vec2>	_reuse_aa_inner_path;
-		pod_vector<widget*> _reuse_fill_x;
-		pod_vector<widget*> _reuse_fill_y;
-
-		vertex*		 _vertex_buffer			  = nullptr;
-		index*		 _index_buffer			  = nullptr;
-		unsigned int _vertex_count_per_buffer = 0;
-		unsigned int _index_count_per_buffer  = 0;
-		unsigned int _buffer_count			  = 0;
-		unsigned int _buffer_counter		  = 0;
+		friend class widget;
+
+		struct flex_item
+		{
+			float base		= 0.0f;
+			float weight	= 0.0f;
+			float target	= 0.0f;
+			float unclamped = 0.0f;
+			bool  frozen	= false;
+		};
+
+		struct layout_scratch
+		{
+			pod_vector<unsigned int> touched;
+			pod_vector<unsigned int> posts;
+			pod_vector<unsigned int> stale;
+			pod_vector<vec2>		 flex_sizes;
+			pod_vector<flex_item>	 flex_items;
+			unsigned int			 measure_hits	= 0;
+			unsigned int			 measure_misses = 0;
+		};
+
+		// Buffer count and summed sizes of a build's output, cheap enough to compare after builds nothing marked as a change.
+		struct draw_totals
+		{
+			unsigned int buffers   = 0;
+			unsigned int vertices  = 0;
+			unsigned int indices   = 0;
+			unsigned int instances = 0;
+
+			bool operator==(const draw_totals& o) const { return buffers == o.buffers && vertices == o.vertices && indices == o.indices && instances == o.instances; }
+		};
+
+		draw_totals get_draw_totals() const;
+
+		pool<widget>			  _widget_pool;
+		layout_arena			  _layout_arena;
+		task_pool				  _task_pool;
+		pod_vector<vec4>		  _clip_stack;
+		pod_vector<input_layer>	  _input_layers;
+		pod_vector<draw_buffer>	  _draw_buffers;
+		pod_vector<unsigned int>  _draw_buffer_table;
+		unsigned int			  _last_draw_buffer		   = 0xFFFFFFFF;
+		bool					  _draw_buffer_table_dirty = true;
+		bool					  _refresh				   = false;
+		pod_vector<tessellation_cache> _tessellation_caches;
+		pod_vector<layout_policy> _layout_policies;
+		pod_vector<viewport>	  _viewports;
+		pod_vector<double>		  _redraw_times;
+		widget*					  _root				   = nullptr;
+		draw_callback			  _on_draw			   = nullptr;
+		pod_vector<widget*>		  _press_state_history = {};
+		pod_vector<widget*>		  _hovered			   = {};
+		vec2					  _mouse_position	   = {};
+		layout_stats			  _layout_stats		   = {};
+		affine					  _transform		   = {};
+		float					  _opacity			   = 1.0f;
+		affine					  _cached_transform	   = {};
+		float					  _cached_opacity	   = 1.0f;
+		float					  _tessellation_tolerance = 0.25f;
+		output_mode				  _output_mode			  = output_mode::triangles;
+
+		pod_vector<vec2>		   _reuse_outer_path;
+		pod_vector<vec2>		   _reuse_inner_path;
+		pod_vector<vec2>		   _reuse_outline_path;
+		pod_vector<vec2>		   _reuse_aa_outer_path;
+		pod_vector<vec2>		   _reuse_aa_inner_path;
+		pod_vector<pod_vector<index>> _strip_patterns;
+		pod_vector<pod_vector<index>> _strip_patterns_ccw;
+		pod_vector<pod_vector<index>> _fan_patterns;
+		pod_vector<layout_scratch> _reuse_layout_scratch;
+		pod_vector<unsigned int>   _reuse_layout_roots;
+		pod_vector<unsigned int>   _reuse_layout_slots;
+		pod_vector<unsigned int>   _reuse_layout_parents;
+		pod_vector<unsigned int>   _reuse_layout_viewports;
+		pod_vector<widget*>		   _reuse_hovered;
+
+		draw_arenas	 _draw_arenas;
+		draw_stats	 _draw_stats;
+		unsigned int _layout_task_min_entries = 0;
+		unsigned int _viewport_tag			  = 0;
 	};
 
 	////////////////////////////////////////////////////////////////////////////////
@@ -1474,349 +2404,1785 @@ namespace vekt
 	float theme::outline_thickness	= 2.0f;
 
 	////////////////////////////////////////////////////////////////////////////////
-	// :: WIDGET IMPL
+	// :: TASK POOL IMPL
 	////////////////////////////////////////////////////////////////////////////////
 
-	void widget::add_child(widget* w)
-	{
-		_widget_data.children.push_back(w);
-		w->_widget_data.parent = this;
-	}
-
-	void widget::remove_child(widget* w)
+	void task_pool::init(unsigned int worker_count)
 	{
-		_widget_data.children.remove(w);
-		w->_widget_data.parent = nullptr;
+		ASSERT(_worker_count == 0 && worker_count > 0);
+		_worker_count = worker_count;
+		_queues		  = new queue[worker_count];
+		_threads	  = new std::thread[worker_count];
+		_stop		  = false;
+
+		for (unsigned int i = 1; i < worker_count; i++)
+			_threads[i] = std::thread(&task_pool::worker_loop, this, i);
 	}
 
-	void widget::set_visible(bool is_visible, bool recursive)
+	void task_pool::uninit()
 	{
-		if (is_visible)
-			_widget_data.flags &= ~widget_flags::wf_invisible;
-		else
-			_widget_data.flags |= widget_flags::wf_invisible;
+		if (_worker_count == 0) return;
 
-		if (recursive)
 		{
-			for (widget* w : _widget_data.children)
-				w->set_visible(is_visible, recursive);
+			std::lock_guard<std::mutex> lock(_sleep_mtx);
+			_stop = true;
 		}
+		_sleep_cv.notify_all();
+
+		for (unsigned int i = 1; i < _worker_count; i++)
+			_threads[i].join();
+
+		delete[] _threads;
+		delete[] _queues;
+		_threads	  = nullptr;
+		_queues		  = nullptr;
+		_worker_count = 0;
 	}
 
-	void widget::pos_pass()
+	void task_pool::push(unsigned int worker, task_func func, void* owner, unsigned int arg, std::atomic<unsigned int>& pending)
 	{
-		if (_widget_data.flags & widget_flags::wf_pos_x_absolute)
-			_widget_data.final_pos.x = _widget_data.pos.x;
-		else if (_widget_data.parent && _widget_data.flags & widget_flags::wf_pos_x_relative)
-		{
-			const float parent_width = _widget_data.parent->_widget_data.final_size.x - _widget_data.parent->_widget_data.margins.left - _widget_data.parent->_widget_data.margins.right;
+		pending.fetch_add(1, std::memory_order_relaxed);
 
-			if (_widget_data.flags & widget_flags::wf_pos_anchor_x_end)
-				_widget_data.final_pos.x = (_widget_data.parent->_widget_data.final_pos.x + _widget_data.parent->_widget_data.margins.left) + (parent_width * _widget_data.pos.x) - _widget_data.final_size.x;
-			else if (_widget_data.flags & widget_flags::wf_pos_anchor_x_center)
-				_widget_data.final_pos.x = (_widget_data.parent->_widget_data.final_pos.x + _widget_data.parent->_widget_data.margins.left) + (parent_width * _widget_data.pos.x) - _widget_data.final_size.x * 0.5f;
-			else
-				_widget_data.final_pos.x = (_widget_data.parent->_widget_data.final_pos.x + _widget_data.parent->_widget_data.margins.left) + (parent_width * _widget_data.pos.x);
+		// Counted before it is published, a thief taking it right away must not decrement first and wrap the counter.
+		_queued.fetch_add(1, std::memory_order_relaxed);
+		{
+			std::lock_guard<std::mutex> lock(_queues[worker].mtx);
+			_queues[worker].tasks.push_back({func, owner, arg, &pending});
 		}
 
-		if (_widget_data.flags & widget_flags::wf_pos_y_absolute)
-			_widget_data.final_pos.y = _widget_data.pos.y;
-		else if (_widget_data.parent && _widget_data.flags & widget_flags::wf_pos_y_relative)
+		// Taking the sleep lock orders the increment against a worker that is about to wait.
 		{
-			const float parent_height = _widget_data.parent->_widget_data.final_size.y - _widget_data.parent->_widget_data.margins.top - _widget_data.parent->_widget_data.margins.bottom;
-
-			if (_widget_data.flags & widget_flags::wf_pos_anchor_y_end)
-				_widget_data.final_pos.y = (_widget_data.parent->_widget_data.final_pos.y + _widget_data.parent->_widget_data.margins.top) + (parent_height * _widget_data.pos.y) - _widget_data.final_size.y;
-			else if (_widget_data.flags & widget_flags::wf_pos_anchor_y_center)
-				_widget_data.final_pos.y = (_widget_data.parent->_widget_data.final_pos.y + _widget_data.parent->_widget_data.margins.top) + (parent_height * _widget_data.pos.y) - _widget_data.final_size.y * 0.5f;
-			else
-				_widget_data.final_pos.y = (_widget_data.parent->_widget_data.final_pos.y + _widget_data.parent->_widget_data.margins.top) + (parent_height * _widget_data.pos.y);
+			std::lock_guard<std::mutex> lock(_sleep_mtx);
 		}
-
-		if (_widget_data.custom_pos_pass) _widget_data.custom_pos_pass(this);
+		_sleep_cv.notify_one();
 	}
 
-	void widget::pos_pass_children()
+	void task_pool::wait(unsigned int worker, std::atomic<unsigned int>& pending)
 	{
-		for (widget* w : _widget_data.children)
+		while (pending.load(std::memory_order_acquire) != 0)
 		{
-			w->pos_pass();
-			w->pos_pass_children();
-			w->pos_pass_post();
+			if (!try_run(worker)) std::this_thread::yield();
 		}
 	}
 
-	void widget::pos_pass_post()
+	bool task_pool::try_run(unsigned int worker)
 	{
-		if (_widget_data.child_positioning == child_positioning::row)
+		task t	   = {};
+		bool found = false;
+
+		for (unsigned int n = 0; n < _worker_count && !found; n++)
 		{
-			float child_x = _widget_data.final_pos.x + _widget_data.margins.left;
+			queue&						q = _queues[(worker + n) % _worker_count];
+			std::lock_guard<std::mutex> lock(q.mtx);
+			if (q.tasks.empty()) continue;
 
-			for (widget* w : _widget_data.children)
+			if (n == 0)
 			{
-				w->_widget_data.final_pos.x = child_x;
-				child_x += _widget_data.spacing + w->_widget_data.final_size.x;
+				t = q.tasks.back();
+				q.tasks.pop_back();
 			}
-		}
-		else if (_widget_data.child_positioning == child_positioning::column)
-		{
-			float child_y = _widget_data.final_pos.y + _widget_data.margins.top;
-
-			for (widget* w : _widget_data.children)
+			else
 			{
-				w->_widget_data.final_pos.y = child_y;
-				child_y += _widget_data.spacing + w->_widget_data.final_size.y;
+				t = q.tasks.front();
+				q.tasks.pop_front();
 			}
+
+			found = true;
 		}
 
-		if (_widget_data.parent) _widget_data.final_pos += _widget_data.parent->_widget_data.scroll_offset;
+		if (!found) return false;
+
+		_queued.fetch_sub(1, std::memory_order_relaxed);
+		t.func(t.owner, t.arg, worker);
+		t.pending->fetch_sub(1, std::memory_order_release);
+		return true;
 	}
 
-	void widget::size_pass()
+	void task_pool::worker_loop(unsigned int worker)
 	{
-
-		if (_widget_gfx.type == gfx_type::_text)
+		while (true)
 		{
-			gfx_text& txt = get_gfx_text();
-			if (txt._dirty)
-			{
-				txt._dirty				= false;
-				_widget_data.final_size = builder::get_text_size(txt, _widget_data.parent ? _widget_data.parent->_widget_data.final_size : vec2{});
-			}
-			return;
-		}
+			if (try_run(worker)) continue;
 
-		if (_widget_data.flags & widget_flags::wf_size_x_absolute)
-			_widget_data.final_size.x = _widget_data.size.x;
-		else if (_widget_data.parent && _widget_data.flags & widget_flags::wf_size_x_relative)
-			_widget_data.final_size.x = (_widget_data.parent->_widget_data.final_size.x - _widget_data.parent->_widget_data.margins.left - _widget_data.parent->_widget_data.margins.right) * _widget_data.size.x;
+			std::unique_lock<std::mutex> lock(_sleep_mtx);
+			_sleep_cv.wait(lock, [this] { return _stop.load() || _queued.load() != 0; });
+			if (_stop) return;
+		}
+	}
 
-		if (_widget_data.flags & widget_flags::wf_size_y_absolute)
-			_widget_data.final_size.y = _widget_data.size.y;
-		else if (_widget_data.parent && _widget_data.flags & widget_flags::wf_size_y_relative)
-			_widget_data.final_size.y = (_widget_data.parent->_widget_data.final_size.y - _widget_data.parent->_widget_data.margins.top - _widget_data.parent->_widget_data.margins.bottom) * _widget_data.size.y;
+	////////////////////////////////////////////////////////////////////////////////
+	// :: LAYOUT ARENA IMPL
+	////////////////////////////////////////////////////////////////////////////////
 
-		size_copy_check();
+	void layout_arena::init(unsigned int capacity)
+	{
+		_capacity = capacity;
+		_count	  = 0;
+
+		pos.resize(capacity);
+		size.resize(capacity);
+		flags.resize(capacity);
+		margins.resize(capacity);
+		spacing.resize(capacity);
+		final_pos.resize(capacity);
+		final_size.resize(capacity);
+		scroll_offset.resize(capacity);
+		grow.resize(capacity);
+		shrink.resize(capacity);
+		min_size.resize(capacity);
+		max_size.resize(capacity);
+		positioning.resize(capacity);
+		hooks.resize(capacity);
+		pos_kernel.resize(capacity);
+		size_kernel.resize(capacity);
+		size_policy.resize(capacity);
+		pos_policy.resize(capacity);
+		state.resize(capacity);
+		prev_pos.resize(capacity);
+		prev_size.resize(capacity);
+		bounds.resize(capacity);
+		sorted_axis.resize(capacity);
+		revision.resize(capacity);
+		measures.resize(capacity);
+		wrap.resize(capacity);
+		grid.resize(capacity);
+		grid_columns.resize(capacity);
+		slot.resize(capacity);
+		parent.resize(capacity);
+		subtree_end.resize(capacity);
+		_entries.resize(capacity);
+	}
 
-		if (_widget_data.custom_size_pass) _widget_data.custom_size_pass(this);
+	void layout_arena::uninit()
+	{
+		pos.clear();
+		size.clear();
+		flags.clear();
+		margins.clear();
+		spacing.clear();
+		final_pos.clear();
+		final_size.clear();
+		scroll_offset.clear();
+		grow.clear();
+		shrink.clear();
+		min_size.clear();
+		max_size.clear();
+		positioning.clear();
+		hooks.clear();
+		pos_kernel.clear();
+		size_kernel.clear();
+		size_policy.clear();
+		pos_policy.clear();
+		state.clear();
+		prev_pos.clear();
+		prev_size.clear();
+		bounds.clear();
+		sorted_axis.clear();
+		bounds_pending.clear();
+		revision.clear();
+		measures.clear();
+		wrap.clear();
+		wraps.clear();
+		grid.clear();
+		grids.clear();
+		grid_columns.clear();
+		_free_wraps.clear();
+		_free_grids.clear();
+		slot.clear();
+		parent.clear();
+		subtree_end.clear();
+		roots.clear();
+		_entries.clear();
+		_reuse_from.clear();
+		_reuse_scratch.clear();
+		_capacity = 0;
+		_count	  = 0;
 	}
 
-	void widget::size_pass_children(pod_vector<widget*>& fill_x, pod_vector<widget*>& fill_y)
+	unsigned int layout_arena::add(unsigned int s)
 	{
-		for (widget* w : _widget_data.children)
-		{
-			w->size_pass();
-			w->size_pass_children(fill_x, fill_y);
-			w->size_pass_post(fill_x, fill_y);
-		}
+		ASSERT(_count < _capacity);
+		const unsigned int i = _count++;
+
+		pos[i]			 = {};
+		size[i]			 = {};
+		flags[i]		 = 0;
+		margins[i]		 = {};
+		spacing[i]		 = 0.0f;
+		final_pos[i]	 = {};
+		final_size[i]	 = {};
+		scroll_offset[i] = {};
+		grow[i]			 = {1.0f, 1.0f};
+		shrink[i]		 = {};
+		min_size[i]		 = {};
+		max_size[i]		 = {FLT_MAX, FLT_MAX};
+		positioning[i]	 = child_positioning::none;
+		hooks[i]		 = 0;
+		pos_kernel[i]	 = 0;
+		size_kernel[i]	 = 0;
+		size_policy[i]	 = 0;
+		pos_policy[i]	 = 0;
+		state[i]		 = layout_state::ls_dirty;
+		prev_pos[i]		 = {};
+		prev_size[i]	 = {};
+		bounds[i]		 = {};
+		sorted_axis[i]	 = sa_none;
+		revision[i]		 = 1;
+		measures[i]		 = {};
+		wrap[i]			 = no_entry;
+		grid[i]			 = no_entry;
+		grid_columns[i]	 = 1;
+		slot[i]			 = s;
+		parent[i]		 = no_entry;
+		subtree_end[i]	 = i + 1;
+		_entries[s]		 = i;
+		return i;
 	}
 
-	void widget::size_pass_post(pod_vector<widget*>& fill_x, pod_vector<widget*>& fill_y)
+	template <typename T>
+	void layout_arena::gather(pod_vector<T>& field, const pod_vector<unsigned int>& from)
 	{
-		/*
-			Max/Total behaviour.
-		*/
-		if (_widget_data.flags & widget_flags::wf_size_x_max_children)
-		{
-			_widget_data.final_size.x = _widget_data.margins.left + _widget_data.margins.right;
+		const unsigned int count = from.size();
+		_reuse_scratch.resize(count * sizeof(T));
+		T* scratch = reinterpret_cast<T*>(_reuse_scratch.data());
 
-			float max = 0.0f;
+		for (unsigned int i = 0; i < count; i++)
+			scratch[i] = field[from[i]];
 
-			for (widget* w : _widget_data.children)
-				max = math::max(w->_widget_data.final_size.x, max);
+		MEMCPY(field.data(), scratch, count * sizeof(T));
+	}
 
-			_widget_data.final_size.x += max;
-		}
-		else if (_widget_data.flags & widget_flags::wf_size_x_total_children)
+	void layout_arena::reorder(const pod_vector<unsigned int>& slots, const pod_vector<unsigned int>& parents)
+	{
+		const unsigned int count = slots.size();
+		_reuse_from.resize(count);
+		for (unsigned int i = 0; i < count; i++)
+			_reuse_from[i] = _entries[slots[i]];
+
+		gather(pos, _reuse_from);
+		gather(size, _reuse_from);
+		gather(flags, _reuse_from);
+		gather(margins, _reuse_from);
+		gather(spacing, _reuse_from);
+		gather(final_pos, _reuse_from);
+		gather(final_size, _reuse_from);
+		gather(scroll_offset, _reuse_from);
+		gather(grow, _reuse_from);
+		gather(shrink, _reuse_from);
+		gather(min_size, _reuse_from);
+		gather(max_size, _reuse_from);
+		gather(positioning, _reuse_from);
+		gather(hooks, _reuse_from);
+		gather(pos_kernel, _reuse_from);
+		gather(size_kernel, _reuse_from);
+		gather(size_policy, _reuse_from);
+		gather(pos_policy, _reuse_from);
+		gather(state, _reuse_from);
+		gather(prev_pos, _reuse_from);
+		gather(prev_size, _reuse_from);
+		gather(bounds, _reuse_from);
+		gather(sorted_axis, _reuse_from);
+		gather(revision, _reuse_from);
+		gather(measures, _reuse_from);
+		gather(wrap, _reuse_from);
+		gather(grid, _reuse_from);
+		gather(grid_columns, _reuse_from);
+
+		// Pre-order keeps every subtree contiguous, so its end is found by folding children ends into their parents back to front.
+		for (unsigned int i = 0; i < count; i++)
 		{
-			_widget_data.final_size.x = _widget_data.margins.left + _widget_data.margins.right;
-			for (widget* w : _widget_data.children)
-				_widget_data.final_size.x += w->_widget_data.final_size.x + _widget_data.spacing;
-			if (!_widget_data.children.empty()) _widget_data.final_size.x -= _widget_data.spacing;
+			slot[i]			  = slots[i];
+			parent[i]		  = parents[i];
+			subtree_end[i]	  = i + 1;
+			_entries[slots[i]] = i;
 		}
 
-		if (_widget_data.flags & widget_flags::wf_size_y_max_children)
+		for (unsigned int i = count; i > 0; i--)
 		{
-			_widget_data.final_size.y = _widget_data.margins.top + _widget_data.margins.bottom;
+			const unsigned int p = parent[i - 1];
+			if (p != no_entry && subtree_end[p] < subtree_end[i - 1]) subtree_end[p] = subtree_end[i - 1];
+		}
 
-			float max = 0.0f;
+		// Entries moved, pending bounds can't be matched to them anymore.
+		bounds_pending.resize(0);
+		_count		= count;
+		order_dirty = false;
+		bounds_all	= true;
+	}
 
-			for (widget* w : _widget_data.children)
-				max = math::max(w->_widget_data.final_size.y, max);
+	template <typename T>
+	unsigned int layout_arena::set_cache(pod_vector<unsigned int>& index, pod_vector<T>& caches, pod_vector<unsigned int>& free_caches, unsigned int i, bool enabled)
+	{
+		if (enabled == (index[i] != no_entry)) return no_entry;
+
+		if (!enabled)
+		{
+			free_caches.push_back(index[i]);
+			index[i] = no_entry;
+			return no_entry;
+		}
 
-			_widget_data.final_size.y += max;
+		if (free_caches.empty())
+		{
+			index[i] = caches.size();
+			caches.push_back({});
 		}
-		else if (_widget_data.flags & widget_flags::wf_size_y_total_children)
+		else
 		{
-			_widget_data.final_size.y = _widget_data.margins.top + _widget_data.margins.bottom;
-			for (widget* w : _widget_data.children)
-				_widget_data.final_size.y += w->_widget_data.final_size.y + _widget_data.spacing;
-			if (!_widget_data.children.empty()) _widget_data.final_size.y -= _widget_data.spacing;
+			index[i] = free_caches[free_caches.size() - 1];
+			free_caches.resize(free_caches.size() - 1);
 		}
 
-		size_copy_check();
+		return index[i];
+	}
 
-		/*
-			Expand/Fill behaviour.
-		*/
-		float non_fill_total_x = -_widget_data.spacing, non_fill_total_y = -_widget_data.spacing;
+	void layout_arena::set_wrap(unsigned int i, bool enabled)
+	{
+		// Revisions start at 1, a recycled cache never matches its new owner.
+		const unsigned int cache = set_cache(wrap, wraps, _free_wraps, i, enabled);
+		if (cache != no_entry) wraps[cache].revision = 0;
+	}
 
-		fill_x.resize(0);
-		fill_y.resize(0);
+	void layout_arena::set_grid(unsigned int i, bool enabled)
+	{
+		set_cache(grid, grids, _free_grids, i, enabled);
+	}
 
-		for (widget* w : _widget_data.children)
-		{
-			if (w->_widget_data.flags & widget_flags::wf_size_x_fill) { fill_x.push_back(w); }
-			else { non_fill_total_x += w->_widget_data.final_size.x + _widget_data.spacing; }
+	void layout_arena::resolve_kernels(unsigned int i)
+	{
+		const unsigned int f = flags[i];
 
-			if (w->_widget_data.flags & widget_flags::wf_size_y_fill) { fill_y.push_back(w); }
-			else { non_fill_total_y += w->_widget_data.final_size.y + _widget_data.spacing; }
-		}
+		auto pos_axis = [f](unsigned int absolute, unsigned int relative, unsigned int center, unsigned int end) -> unsigned int {
+			if (f & absolute) return pka_absolute;
+			if (!(f & relative)) return pka_none;
+			return f & end ? pka_end : (f & center ? pka_center : pka_start);
+		};
 
-		if (!fill_x.empty())
-		{
-			const float diff  = _widget_data.final_size.x - non_fill_total_x;
-			const float share = diff / static_cast<float>(fill_x.size());
-			for (widget* w : fill_x)
-				w->_widget_data.final_size.x = share;
-		}
+		auto size_axis = [f](unsigned int absolute, unsigned int relative, unsigned int copy) -> unsigned int {
+			if (f & absolute) return ska_absolute;
+			if (f & relative) return ska_relative;
+			return f & copy ? ska_copy : ska_none;
+		};
 
-		if (!fill_y.empty())
+		const unsigned int pos_x  = pos_axis(widget_flags::wf_pos_x_absolute, widget_flags::wf_pos_x_relative, widget_flags::wf_pos_anchor_x_center, widget_flags::wf_pos_anchor_x_end);
+		const unsigned int pos_y  = pos_axis(widget_flags::wf_pos_y_absolute, widget_flags::wf_pos_y_relative, widget_flags::wf_pos_anchor_y_center, widget_flags::wf_pos_anchor_y_end);
+		const unsigned int size_x = size_axis(widget_flags::wf_size_x_absolute, widget_flags::wf_size_x_relative, widget_flags::wf_size_x_copy_y);
+		const unsigned int size_y = size_axis(widget_flags::wf_size_y_absolute, widget_flags::wf_size_y_relative, widget_flags::wf_size_y_copy_x);
+		pos_kernel[i]			  = static_cast<unsigned char>(pos_x + pos_y * pka_count);
+		size_kernel[i]			  = static_cast<unsigned char>(size_x + size_y * ska_count);
+	}
+
+	void layout_arena::mark_bounds(unsigned int i)
+	{
+		// Ancestors' bounds cover this entry, so they are refreshed too. A marked ancestor already has its own ancestors marked.
+		while (i != no_entry && !(state[i] & layout_state::ls_bounds))
 		{
-			const float diff  = _widget_data.final_size.y - non_fill_total_y;
-			const float share = diff / static_cast<float>(fill_y.size());
-			for (widget* w : fill_y)
-				w->_widget_data.final_size.y = share;
+			state[i] |= layout_state::ls_bounds;
+			bounds_pending.push_back(i);
+			i = parent[i];
 		}
 	}
 
-	void widget::size_copy_check()
+	template <pos_kernel_axis M, float vec2::*Axis, float margins::*Start, float margins::*End>
+	inline void layout_pos_axis(layout_arena& a, unsigned int i, unsigned int p)
 	{
-		if (_widget_data.flags & widget_flags::wf_size_x_copy_y)
-			_widget_data.final_size.x = _widget_data.final_size.y * (_widget_data.flags & widget_flags::wf_size_x_relative ? _widget_data.size.x : 1.0f);
-		else if (_widget_data.flags & widget_flags::wf_size_y_copy_x)
-			_widget_data.final_size.y = _widget_data.final_size.x * (_widget_data.flags & widget_flags::wf_size_y_relative ? _widget_data.size.y : 1.0f);
+		if constexpr (M == pka_absolute)
+			a.final_pos[i].*Axis = a.pos[i].*Axis;
+		else if constexpr (M != pka_none)
+		{
+			if (p == layout_arena::no_entry) return;
+
+			const float start = a.final_pos[p].*Axis + a.margins[p].*Start;
+			const float span  = a.final_size[p].*Axis - a.margins[p].*Start - a.margins[p].*End;
+			float&		pos	  = a.final_pos[i].*Axis;
+
+			if constexpr (M == pka_end)
+				pos = start + (span * a.pos[i].*Axis) - a.final_size[i].*Axis;
+			else if constexpr (M == pka_center)
+				pos = start + (span * a.pos[i].*Axis) - a.final_size[i].*Axis * 0.5f;
+			else
+				pos = start + (span * a.pos[i].*Axis);
+		}
 	}
 
-	bool widget::draw_pass_clip_check(builder& builder)
+	template <pos_kernel_axis X, pos_kernel_axis Y>
+	void layout_pos_kernel(layout_arena& a, unsigned int i)
 	{
-		if (_widget_gfx.type == gfx_type::filled_rect && get_gfx_filled_rect().clip_children) { return builder.push_to_clip_stack(get_clip_rect()); }
-		else if (_widget_gfx.type == gfx_type::stroke_rect && get_gfx_stroke_rect().clip_children) { return builder.push_to_clip_stack(get_clip_rect()); }
-		return false;
+		const unsigned int p = a.parent[i];
+		layout_pos_axis<X, &vec2::x, &margins::left, &margins::right>(a, i, p);
+		layout_pos_axis<Y, &vec2::y, &margins::top, &margins::bottom>(a, i, p);
 	}
 
-	void widget::draw_pass(builder& builder)
+	template <size_kernel_axis M, float vec2::*Axis, float margins::*Start, float margins::*End>
+	inline void layout_size_axis(layout_arena& a, unsigned int i, unsigned int p)
 	{
-		if (_widget_gfx.type == gfx_type::filled_rect)
+		if constexpr (M == ska_absolute)
+			a.final_size[i].*Axis = a.size[i].*Axis;
+		else if constexpr (M == ska_relative)
 		{
-			builder.add_filled_rect(_widget_gfx.get_data<gfx_filled_rect>(), _widget_data.final_pos, _widget_data.final_pos + _widget_data.final_size, _widget_gfx.draw_order, _widget_gfx.user_data, _is_hovered, _press_states[0]);
+			if (p != layout_arena::no_entry) a.final_size[i].*Axis = (a.final_size[p].*Axis - a.margins[p].*Start - a.margins[p].*End) * a.size[i].*Axis;
 		}
-		else if (_widget_gfx.type == gfx_type::stroke_rect)
-		{
-			builder.add_stroke_rect(_widget_gfx.get_data<gfx_stroke_rect>(), _widget_data.final_pos, _widget_data.final_pos + _widget_data.final_size, _widget_gfx.draw_order, _widget_gfx.user_data, _is_hovered, _press_states[0]);
-		}
-		else if (_widget_gfx.type == gfx_type::_text) { builder.add_text(_widget_gfx.get_data<gfx_text>(), _widget_data.final_pos, _widget_data.final_size, _widget_gfx.draw_order, _widget_gfx.user_data, _is_hovered, _press_states[0]); }
 	}
 
-	void widget::draw_pass_children(builder& builder)
+	template <size_kernel_axis X, size_kernel_axis Y>
+	void layout_size_kernel(layout_arena& a, unsigned int i)
 	{
-		const bool clip_children = (_widget_gfx.type == gfx_type::filled_rect && get_gfx_filled_rect().clip_children) || _widget_gfx.type == gfx_type::stroke_rect && get_gfx_stroke_rect().clip_children;
-		if (clip_children) builder.push_to_clip_stack_if_intersects(get_clip_rect());
+		const unsigned int p = a.parent[i];
+		layout_size_axis<X, &vec2::x, &margins::left, &margins::right>(a, i, p);
+		layout_size_axis<Y, &vec2::y, &margins::top, &margins::bottom>(a, i, p);
+
+		// Copying clears the relative flag of the same axis, so the copy is never scaled. Width copies first when both axes ask.
+		vec2& size = a.final_size[i];
+		if constexpr (X == ska_copy)
+			size.x = size.y;
+		else if constexpr (Y == ska_copy)
+			size.y = size.x;
+	}
 
-		for (widget* w : _widget_data.children)
-		{
-			if (!w->get_is_visible()) continue;
+	typedef void (*layout_kernel_func)(layout_arena& a, unsigned int i);
 
-			// For this child, whether it clips its own children or not, we check if it intersects into currect clip rect and draw only if so.
-			const vec4 intersection = builder.calculate_intersection(builder.get_current_clip(), w->get_clip_rect());
-			if (intersection.z <= 0 || intersection.w <= 0) continue;
+	template <typename S>
+	struct layout_pos_kernels;
 
-			w->draw_pass(builder);
-			w->draw_pass_children(builder);
-		}
+	template <typename S>
+	struct layout_size_kernels;
 
-		if (clip_children) builder.pop_clip_stack();
-	}
+	// Every combination of the two axes, indexed the way resolve_kernels packs them.
+	template <unsigned int... K>
+	struct layout_pos_kernels<std::integer_sequence<unsigned int, K...>>
+	{
+		static constexpr layout_kernel_func table[] = {&layout_pos_kernel<static_cast<pos_kernel_axis>(K % pka_count), static_cast<pos_kernel_axis>(K / pka_count)>...};
+	};
 
-	void widget::draw_pass_clip_check_end(builder& builder)
+	template <unsigned int... K>
+	struct layout_size_kernels<std::integer_sequence<unsigned int, K...>>
 	{
-		if (_widget_gfx.type == gfx_type::filled_rect && get_gfx_filled_rect().clip_children || (_widget_gfx.type == gfx_type::stroke_rect && get_gfx_stroke_rect().clip_children)) { builder.pop_clip_stack(); }
-	}
+		static constexpr layout_kernel_func table[] = {&layout_size_kernel<static_cast<size_kernel_axis>(K % ska_count), static_cast<size_kernel_axis>(K / ska_count)>...};
+	};
+
+	typedef layout_pos_kernels<std::make_integer_sequence<unsigned int, pka_count * pka_count>>	pos_kernels;
+	typedef layout_size_kernels<std::make_integer_sequence<unsigned int, ska_count * ska_count>> size_kernels;
 
 	////////////////////////////////////////////////////////////////////////////////
-	// :: BUILDER IMPL
+	// :: WIDGET IMPL
 	////////////////////////////////////////////////////////////////////////////////
 
-	void builder::init(const init_config& conf)
+	void widget::add_child(widget* w)
 	{
-		ASSERT(conf.vertex_buffer_sz > 0 && conf.index_buffer_sz > 0 && conf.vertex_buffer_sz > 0 && conf.widget_buffer_sz > 0);
-		ASSERT(conf.buffer_count * sizeof(vertex) < conf.vertex_buffer_sz && conf.buffer_count * sizeof(index) < conf.index_buffer_sz);
-
-		const unsigned int widget_count = static_cast<unsigned int>(conf.widget_buffer_sz / sizeof(widget));
-		_widget_pool.init(widget_count);
-
-		const size_t vertex_count = conf.vertex_buffer_sz / sizeof(vertex);
-		const size_t index_count  = conf.index_buffer_sz / sizeof(index);
-		_vertex_count_per_buffer  = static_cast<unsigned int>(vertex_count / conf.buffer_count);
-		_index_count_per_buffer	  = static_cast<unsigned int>(index_count / conf.buffer_count);
-		_buffer_count			  = conf.buffer_count;
+		_widget_data.children.push_back(w);
+		w->_widget_data.parent = this;
+		w->mark_layout_dirty();
+		_arena->order_dirty = true;
+	}
 
-		_vertex_buffer = reinterpret_cast<vertex*>(MALLOC(sizeof(vertex) * vertex_count));
-		_index_buffer  = reinterpret_cast<index*>(MALLOC(sizeof(index) * index_count));
+	void widget::remove_child(widget* w)
+	{
+		_widget_data.children.remove(w);
+		w->_widget_data.parent = nullptr;
+		mark_layout_dirty();
+		_arena->order_dirty = true;
+	}
+
+	void widget::mark_layout_dirty()
+	{
+		_arena->revision[get_layout_index()]++;
+		mark_layout_pending();
+	}
+
+	void widget::mark_layout_pending()
+	{
+		_arena->state[get_layout_index()] |= layout_state::ls_dirty;
+		_arena->redraw = true;
+
+		widget* p = _widget_data.parent;
+		while (p)
+		{
+			unsigned char& state = _arena->state[p->get_layout_index()];
+			if (state & layout_state::ls_child_dirty) return;
+			state |= layout_state::ls_child_dirty;
+
+			if (p->get_is_layout_boundary())
+			{
+				_arena->roots.push_back(p);
+				return;
+			}
+
+			p = p->_widget_data.parent;
+		}
+	}
+
+	void widget::set_transform(const widget_transform& transform)
+	{
+		const unsigned int i   = get_layout_index();
+		_widget_gfx.transform = transform;
+
+		if (transform.is_identity())
+			_arena->hooks[i] &= ~layout_hook::lh_transform;
+		else
+			_arena->hooks[i] |= layout_hook::lh_transform;
+
+		if (!_arena->order_dirty) _arena->mark_bounds(i);
+		mark_redraw();
+	}
+
+	void widget::set_visible(bool is_visible, bool recursive)
+	{
+		unsigned int& flags = _arena->flags[get_layout_index()];
+		mark_redraw();
+		if (is_visible)
+			flags &= ~widget_flags::wf_invisible;
+		else
+			flags |= widget_flags::wf_invisible;
+
+		if (recursive)
+		{
+			for (widget* w : _widget_data.children)
+				w->set_visible(is_visible, recursive);
+		}
+	}
+
+	bool widget::draw_pass_clip_check(builder& builder)
+	{
+		if (_widget_gfx.type == gfx_type::filled_rect && _widget_gfx.get_data<gfx_filled_rect>().clip_children) { return builder.push_to_clip_stack(get_clip_rect()); }
+		else if (_widget_gfx.type == gfx_type::stroke_rect && _widget_gfx.get_data<gfx_stroke_rect>().clip_children) { return builder.push_to_clip_stack(get_clip_rect()); }
+		return false;
+	}
+
+	void widget::draw_pass(builder& builder)
+	{
+		const vec2& final_pos  = get_final_pos();
+		const vec2& final_size = get_final_size();
+
+		if (_widget_gfx.type == gfx_type::filled_rect)
+		{
+			builder.add_filled_rect(_widget_gfx.get_data<gfx_filled_rect>(), final_pos, final_pos + final_size, _widget_gfx.draw_order, _widget_gfx.user_data, _is_hovered, _press_states[0], &builder._tessellation_caches[_pool_handle.value]);
+		}
+		else if (_widget_gfx.type == gfx_type::stroke_rect)
+		{
+			builder.add_stroke_rect(_widget_gfx.get_data<gfx_stroke_rect>(), final_pos, final_pos + final_size, _widget_gfx.draw_order, _widget_gfx.user_data, _is_hovered, _press_states[0], &builder._tessellation_caches[_pool_handle.value]);
+		}
+		else if (_widget_gfx.type == gfx_type::_text) { builder.add_text(_widget_gfx.get_data<gfx_text>(), final_pos, final_size, _widget_gfx.draw_order, _widget_gfx.user_data, _is_hovered, _press_states[0]); }
+	}
+
+	void widget::draw_pass_children(builder& builder)
+	{
+		const bool clip_children = (_widget_gfx.type == gfx_type::filled_rect && _widget_gfx.get_data<gfx_filled_rect>().clip_children) || _widget_gfx.type == gfx_type::stroke_rect && _widget_gfx.get_data<gfx_stroke_rect>().clip_children;
+		if (clip_children) builder.push_to_clip_stack_if_intersects(builder.get_transformed_rect(get_clip_rect()));
+
+		const affine parent_transform = builder._transform;
+		const float	 parent_opacity	  = builder._opacity;
+
+		// Row and column children come out in order, only the ones overlapping the clip are walked. Clip and bounds share a space while untransformed.
+		unsigned int first = 0, last = _widget_data.children.size();
+		if (parent_transform.is_identity())
+		{
+			const vec4 clip = builder.get_current_clip();
+			if (_arena->sorted_axis[get_layout_index()] == sa_x)
+				builder.get_child_range(this, clip.x, clip.x + clip.z, first, last);
+			else
+				builder.get_child_range(this, clip.y, clip.y + clip.w, first, last);
+		}
+
+		for (unsigned int k = first; k < last; k++)
+		{
+			widget* w = _widget_data.children[k];
+			if (!w->get_is_visible() || w->_widget_gfx.opacity <= 0.0f) continue;
+
+			// Bounds cover the child's whole subtree including anything overflowing it, so one test against the current clip rejects all of it.
+			const vec4 intersection = builder.calculate_intersection(builder.get_current_clip(), builder.get_transformed_rect(_arena->bounds[w->get_layout_index()]));
+			if (intersection.z <= 0 || intersection.w <= 0) continue;
+
+			if (!w->_widget_gfx.transform.is_identity()) builder._transform = parent_transform * w->get_transform_matrix();
+			builder._opacity = parent_opacity * w->_widget_gfx.opacity;
+
+			w->draw_pass(builder);
+			w->draw_pass_children(builder);
+
+			builder._transform = parent_transform;
+		}
+
+		builder._opacity = parent_opacity;
+
+		if (clip_children) builder.pop_clip_stack();
+	}
+
+	void widget::draw_pass_clip_check_end(builder& builder)
+	{
+		if (_widget_gfx.type == gfx_type::filled_rect && _widget_gfx.get_data<gfx_filled_rect>().clip_children || (_widget_gfx.type == gfx_type::stroke_rect && _widget_gfx.get_data<gfx_stroke_rect>().clip_children)) { builder.pop_clip_stack(); }
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	// :: BUILDER IMPL
+	////////////////////////////////////////////////////////////////////////////////
+
+	void builder::init(const init_config& conf)
+	{
+		ASSERT(conf.vertex_buffer_sz > 0 && conf.index_buffer_sz > 0 && conf.vertex_buffer_sz > 0 && conf.widget_buffer_sz > 0);
+
+		const unsigned int widget_count = static_cast<unsigned int>(conf.widget_buffer_sz / sizeof(widget));
+		_widget_pool.init(widget_count);
+		_layout_arena.init(widget_count);
+		_tessellation_caches.resize(widget_count);
+
+		const unsigned int layout_threads = conf.layout_thread_count > 1 ? conf.layout_thread_count : 1;
+		_reuse_layout_scratch.resize(layout_threads);
+		_layout_task_min_entries = conf.layout_task_min_entries;
+		if (layout_threads > 1) _task_pool.init(layout_threads);
+
+		// Id 0 stands for no policy.
+		_layout_policies.resize(0);
+		_layout_policies.push_back({});
+
+		_draw_arenas.vertices.init(conf.vertex_buffer_sz / sizeof(vertex));
+		_draw_arenas.indices.init(conf.index_buffer_sz / sizeof(index));
+		_draw_arenas.instances.init(conf.instance_buffer_sz / sizeof(rect_instance));
+		_draw_buffers.reserve(static_cast<unsigned int>(conf.buffer_count));
+		_draw_stats = {};
+	}
+
+	void builder::uninit()
+	{
+		_task_pool.uninit();
+		_widget_pool.clear();
+		_layout_arena.uninit();
+		_tessellation_caches.clear();
+		_strip_patterns.clear();
+		_strip_patterns_ccw.clear();
+		_fan_patterns.clear();
+		_reuse_layout_scratch.clear();
+		_layout_policies.clear();
+
+		_draw_buffers.clear();
+		_draw_buffer_table_dirty = true;
+		_draw_arenas.vertices.uninit();
+		_draw_arenas.indices.uninit();
+		_draw_arenas.instances.uninit();
+	}
+
+	builder::build_result builder::build(const vec2& screen_size, double time)
+	{
+		ASSERT(_root);
+		layout_arena& a		 = _layout_arena;
+		build_result  result = {};
+
+		// Requests that came due rebuild now, the rest wait.
+		unsigned int kept = 0;
+		for (double t : _redraw_times)
+		{
+			if (t <= time)
+				_refresh = true;
+			else
+			{
+				_redraw_times[kept++] = t;
+				result.wake_time	  = math::min(result.wake_time, t);
+			}
+		}
+		_redraw_times.resize(kept);
+
+		// Nothing changed since the last build, its draw buffers are still what flush() would emit.
+		if (!a.redraw && !_refresh && !a.order_dirty && _viewports[0].size == screen_size) return result;
+
+		// Setters, accessors, press and hover changes mark definite changes. Input events and due requests only say the output may have changed, for those a different
+		// buffer count or size tells whether it did.
+		const bool		  definite = a.redraw || a.order_dirty || _viewports[0].size != screen_size;
+		const draw_totals last	   = get_draw_totals();
+		_refresh				   = false;
+		_viewports[0].size		   = screen_size;
+		build_viewports(nullptr);
+		result.changed = definite || !(get_draw_totals() == last);
+
+		// Only widgets sized against a size that moved later in the same pass were marked again, the host should build again right away. Anything else marked while
+		// building was laid out by it.
+		bool stale = false;
+		for (const layout_scratch& scratch : _reuse_layout_scratch)
+			stale |= !scratch.stale.empty();
+
+		a.redraw = stale;
+		if (stale) result.wake_time = time;
+		return result;
+	}
+
+	void builder::request_redraw(double time)
+	{
+		_redraw_times.push_back(time);
+	}
+
+	void builder::build_viewport(widget* root)
+	{
+		for (const viewport& vp : _viewports)
+		{
+			if (vp.root != root) continue;
+			build_viewports(&vp);
+			return;
+		}
+
+		V_ERR("vekt::builder::build_viewport -> Widget is not a viewport root!");
+	}
+
+	void builder::build_viewports(const viewport* only)
+	{
+		_clip_stack.resize(0);
+		release_draw_buffers(only);
+
+		/* size & pos & draw */
+		builder&		   bd		  = *this;
+		const unsigned int root_flags = widget_flags::wf_pos_x_absolute | widget_flags::wf_pos_y_absolute | widget_flags::wf_size_x_absolute | widget_flags::wf_size_y_absolute;
+		if (_layout_arena.order_dirty) layout_order();
+
+		// Viewport roots are absolute and sized to their viewport, all of them lay out in the same pass.
+		layout_arena& a = _layout_arena;
+		for (const viewport& vp : _viewports)
+		{
+			if (only ? &vp != only : vp.retained) continue;
+			const unsigned int i = vp.root->get_layout_index();
+			if (a.size[i] != vp.size || a.pos[i] != vec2() || a.flags[i] != root_flags) vp.root->mark_layout_dirty();
+			a.pos[i]   = {0.0f, 0.0f};
+			a.size[i]  = vp.size;
+			a.flags[i] = root_flags;
+			a.resolve_kernels(i);
+		}
+
+		layout(only);
+		layout_bounds();
+
+		for (const viewport& vp : _viewports)
+		{
+			if (only ? &vp != only : vp.retained) continue;
+			widget* root  = vp.root;
+			_viewport_tag = vp.tag;
+
+			// Transforms only touch vertices from here on, changing one never dirtied layout above.
+			_transform = root->_widget_gfx.transform.is_identity() ? affine() : root->get_transform_matrix();
+			_opacity   = root->_widget_gfx.opacity;
+			if (_opacity <= 0.0f) continue;
+
+			root->draw_pass(bd);
+
+			_clip_stack.push_back({0.0f, 0.0f, vp.size.x, vp.size.y});
+			root->draw_pass_children(bd);
+			_clip_stack.remove(_clip_stack.size() - 1);
+		}
+
+		_viewport_tag = 0;
+	}
+
+	void builder::release_draw_buffers(const viewport* only)
+	{
+		unsigned int kept = 0;
+
+		// Without a viewport, everything but the buffers of retained viewports goes.
+		for (unsigned int i = 0; i < _draw_buffers.size(); i++)
+		{
+			const draw_buffer& db	   = _draw_buffers[i];
+			bool			   release = !only || db.viewport == only->tag;
+
+			for (unsigned int k = 0; k < _viewports.size() && !only; k++)
+				release &= !(_viewports[k].retained && _viewports[k].tag == db.viewport);
+
+			if (release)
+				_draw_buffers[i].release();
+			else
+				_draw_buffers[kept++] = db;
+		}
+
+		_draw_buffers.resize(kept);
+		_draw_buffer_table_dirty = true;
+	}
+
+	bool builder::get_is_in_scope(unsigned int i, const viewport* only) const
+	{
+		const layout_arena& a = _layout_arena;
+
+		for (const viewport& vp : _viewports)
+		{
+			if (only ? &vp != only : !vp.retained) continue;
+			const unsigned int r	  = vp.root->get_layout_index();
+			const bool		   inside = i >= r && i < a.subtree_end[r];
+			if (only) return inside;
+			if (inside) return false;
+		}
+
+		return !only;
+	}
+
+	void builder::add_viewport(widget* root, const vec2& size, unsigned int tag, bool retained)
+	{
+		ASSERT(root && !root->_widget_data.parent && !_viewports.empty());
+
+		for (viewport& vp : _viewports)
+		{
+			if (vp.root == root)
+			{
+				V_WARN("vekt::builder::add_viewport -> Widget is already a viewport root, overriding its size and tag! tag: %d", tag);
+				vp.size		= size;
+				vp.tag		= tag;
+				vp.retained = retained;
+				return;
+			}
+		}
+
+		_viewports.push_back({root, size, tag, retained});
+		_layout_arena.order_dirty = true;
+		_layout_arena.redraw	  = true;
+	}
+
+	void builder::remove_viewport(widget* root)
+	{
+		for (unsigned int i = 1; i < _viewports.size(); i++)
+		{
+			if (_viewports[i].root != root) continue;
+			release_draw_buffers(&_viewports[i]);
+			_viewports.remove(i);
+			_layout_arena.order_dirty = true;
+			_layout_arena.redraw	  = true;
+			return;
+		}
+	}
+
+	void builder::set_viewport_size(widget* root, const vec2& size)
+	{
+		for (viewport& vp : _viewports)
+		{
+			if (vp.root != root || vp.size == size) continue;
+			vp.size				 = size;
+			_layout_arena.redraw = true;
+		}
+	}
+
+	void builder::layout(const viewport* only)
+	{
+		layout_arena& a = _layout_arena;
+		for (layout_scratch& scratch : _reuse_layout_scratch)
+		{
+			scratch.touched.resize(0);
+			scratch.posts.resize(0);
+			scratch.stale.resize(0);
+			scratch.measure_hits   = 0;
+			scratch.measure_misses = 0;
+		}
+
+		// Ancestors precede descendants in the arena, so ascending entries put outer boundaries first and an inner one is skipped once an outer pass reached it.
+		// Boundaries of viewports left out of this build stay queued for theirs.
+		_reuse_layout_roots.resize(0);
+		unsigned int kept = 0;
+		for (widget* w : a.roots)
+		{
+			const unsigned int i = w->get_layout_index();
+			if (get_is_in_scope(i, only))
+				_reuse_layout_roots.push_back(i);
+			else
+				a.roots[kept++] = w;
+		}
+		a.roots.resize(kept);
+		std::sort(_reuse_layout_roots.begin(), _reuse_layout_roots.end());
+
+		// All sizes settle before any position is resolved.
+		_reuse_layout_viewports.resize(0);
+		for (const viewport& vp : _viewports)
+		{
+			const unsigned int i = vp.root->get_layout_index();
+			if ((only ? &vp == only : !vp.retained) && (a.state[i] & (layout_state::ls_dirty | layout_state::ls_child_dirty))) _reuse_layout_viewports.push_back(i);
+		}
+
+		for (unsigned int i : _reuse_layout_viewports)
+			layout_size_subtree(i, false, 0);
+
+		for (unsigned int i : _reuse_layout_roots)
+		{
+			if ((a.state[i] & layout_state::ls_sized) || !(a.state[i] & layout_state::ls_child_dirty)) continue;
+			layout_track(i, 0);
+			a.state[i] = (a.state[i] | layout_state::ls_sized) & ~layout_state::ls_size_all;
+			layout_size_children(i, false, 0);
+			size_pass_post(i, 0);
+		}
+
+		for (unsigned int i : _reuse_layout_viewports)
+		{
+			pos_pass(i);
+			layout_pos_children(i, 0);
+		}
+
+		for (unsigned int i : _reuse_layout_roots)
+		{
+			if ((a.state[i] & layout_state::ls_positioned) || !(a.state[i] & layout_state::ls_child_dirty)) continue;
+			layout_pos_children(i, 0);
+		}
+
+		// Sizes that fed back into an ancestor (relative inside max/total children) converge over builds, only widgets sized against a size that moved afterwards are laid out again next build.
+		_layout_stats = {};
+		for (layout_scratch& scratch : _reuse_layout_scratch)
+		{
+			for (unsigned int i : scratch.touched)
+				a.state[i] &= layout_state::ls_bounds;
+			_layout_stats.measure_hits += scratch.measure_hits;
+			_layout_stats.measure_misses += scratch.measure_misses;
+		}
+
+		for (layout_scratch& scratch : _reuse_layout_scratch)
+		{
+			for (unsigned int i : scratch.touched)
+			{
+				if (!a.bounds_all && (a.prev_pos[i] != a.final_pos[i] || a.prev_size[i] != a.final_size[i])) a.mark_bounds(i);
+			}
+
+			// Dirty rather than pending, cached measurements keyed on the stale inputs can't be reused.
+			for (unsigned int i : scratch.stale)
+				_widget_pool.get(a.slot[i])->mark_layout_dirty();
+		}
+	}
+
+	void builder::layout_bounds()
+	{
+		layout_arena& a = _layout_arena;
+
+		// Descendants follow their ancestors in the arena, so walking entries back to front settles every child's bounds before its parent folds them in.
+		if (a.bounds_all)
+		{
+			for (unsigned int i = a.get_count(); i > 0; i--)
+				layout_bounds_entry(i - 1);
+			for (unsigned int i = 0; i < a.get_count(); i++)
+				a.state[i] &= ~layout_state::ls_bounds;
+			a.bounds_pending.resize(0);
+			a.bounds_all = false;
+			return;
+		}
+
+		if (a.bounds_pending.empty()) return;
+		std::sort(a.bounds_pending.begin(), a.bounds_pending.end(), [](unsigned int x, unsigned int y) { return x > y; });
+
+		for (unsigned int i : a.bounds_pending)
+		{
+			if (!(a.state[i] & layout_state::ls_bounds)) continue;
+			a.state[i] &= ~layout_state::ls_bounds;
+			layout_bounds_entry(i);
+		}
+
+		a.bounds_pending.resize(0);
+	}
+
+	void builder::layout_bounds_entry(unsigned int i)
+	{
+		layout_arena&			a			= _layout_arena;
+		const child_positioning positioning = a.positioning[i];
+		vec2					lo			= a.final_pos[i];
+		vec2					hi			= a.final_pos[i] + a.final_size[i];
+		unsigned char			axis		= positioning == child_positioning::row ? sa_x : (positioning == child_positioning::column ? sa_y : sa_none);
+		const vec4*				prev		= nullptr;
+
+		// Clipped children are cut to the widget's own rect, so nothing of them can reach past it to be culled against or hit.
+		widget*		  w				= _widget_pool.get(a.slot[i]);
+		const bool	  clip_children = (w->_widget_gfx.type == gfx_type::filled_rect && w->_widget_gfx.get_data<gfx_filled_rect>().clip_children) ||
+								  (w->_widget_gfx.type == gfx_type::stroke_rect && w->_widget_gfx.get_data<gfx_stroke_rect>().clip_children);
+
+		for (unsigned int c = i + 1; c < a.subtree_end[i]; c = a.subtree_end[c])
+		{
+			const vec4& b = a.bounds[c];
+			if (!clip_children)
+			{
+				lo = {math::min(lo.x, b.x), math::min(lo.y, b.y)};
+				hi = {math::max(hi.x, b.x + b.z), math::max(hi.y, b.y + b.w)};
+			}
+
+			// Overflowing or transformed children can break the order the row or column placed them in.
+			if (prev && axis == sa_x && (b.x < prev->x || b.x + b.z < prev->x + prev->z)) axis = sa_none;
+			if (prev && axis == sa_y && (b.y < prev->y || b.y + b.w < prev->y + prev->w)) axis = sa_none;
+			prev = &b;
+		}
+
+		a.sorted_axis[i] = axis;
+
+		const vec4 rect = {lo.x, lo.y, hi.x - lo.x, hi.y - lo.y};
+		a.bounds[i]		= a.hooks[i] & layout_hook::lh_transform ? w->get_transform_matrix().apply_rect(rect) : rect;
+	}
+
+	void builder::get_child_range(widget* w, float lo, float hi, unsigned int& first, unsigned int& last) const
+	{
+		const pod_vector<widget*>& children = w->_widget_data.children;
+		const layout_arena&		   a		= _layout_arena;
+		const unsigned char		   axis		= a.sorted_axis[w->get_layout_index()];
+		first								= 0;
+		last								= children.size();
+		if (axis == sa_none) return;
+
+		float vec4::*start	= axis == sa_x ? &vec4::x : &vec4::y;
+		float vec4::*extent = axis == sa_x ? &vec4::z : &vec4::w;
+
+		// First child ending at or after lo, then every following child starting at or before hi.
+		unsigned int count = last;
+		while (count > 0)
+		{
+			const unsigned int step = count / 2;
+			const vec4&		   b	= a.bounds[children[first + step]->get_layout_index()];
+			if (b.*start + b.*extent < lo)
+			{
+				first += step + 1;
+				count -= step + 1;
+			}
+			else
+				count = step;
+		}
+
+		last = first;
+		while (last < children.size() && a.bounds[children[last]->get_layout_index()].*start <= hi)
+			last++;
+	}
+
+	void builder::layout_order()
+	{
+		layout_arena& a = _layout_arena;
+		_reuse_layout_slots.resize(0);
+		_reuse_layout_parents.resize(0);
+
+		// The main root comes first, then the other viewports in the order they were added.
+		for (const viewport& vp : _viewports)
+			layout_order_append(vp.root, layout_arena::no_entry);
+
+		// Widgets outside every viewport's tree keep their entries behind them, stale entries of freed or reused slots are dropped.
+		const unsigned int count = a.get_count();
+		for (unsigned int i = 0; i < count; i++)
+		{
+			const unsigned int slot = a.slot[i];
+			if (a.get_entry(slot) != i) continue;
+			widget* w = _widget_pool.get(slot);
+			if (!w->_pool_handle.alive || w->_widget_data.parent) continue;
+
+			bool is_viewport = false;
+			for (const viewport& vp : _viewports)
+				is_viewport |= vp.root == w;
+			if (!is_viewport) layout_order_append(w, layout_arena::no_entry);
+		}
+
+		a.reorder(_reuse_layout_slots, _reuse_layout_parents);
+	}
+
+	void builder::layout_order_append(widget* w, unsigned int parent)
+	{
+		const unsigned int i = _reuse_layout_slots.size();
+		_reuse_layout_slots.push_back(w->_pool_handle.value);
+		_reuse_layout_parents.push_back(parent);
+
+		for (widget* c : w->_widget_data.children)
+			layout_order_append(c, i);
+	}
+
+	void builder::layout_track(unsigned int i, unsigned int worker)
+	{
+		layout_arena& a = _layout_arena;
+		if (a.state[i] & layout_state::ls_visited) return;
+		a.state[i] |= layout_state::ls_visited;
+		a.prev_pos[i]  = a.final_pos[i];
+		a.prev_size[i] = a.final_size[i];
+		_reuse_layout_scratch[worker].touched.push_back(i);
+	}
+
+	void builder::layout_size(unsigned int i, bool force, unsigned int worker)
+	{
+		layout_arena& a = _layout_arena;
+		layout_track(i, worker);
+		size_pass(i, worker);
+		size_clamp(i);
+
+		if (force || (a.state[i] & layout_state::ls_dirty) || a.prev_size[i] != a.final_size[i])
+			a.state[i] |= layout_state::ls_sized | layout_state::ls_size_all;
+		else
+			a.state[i] = (a.state[i] | layout_state::ls_sized) & ~layout_state::ls_size_all;
+	}
+
+	void builder::layout_size_subtree(unsigned int i, bool force, unsigned int worker)
+	{
+		layout_size(i, force, worker);
+		layout_size_children(i, force, worker);
+		size_pass_post(i, worker);
+	}
+
+	void builder::layout_size_children(unsigned int i, bool force, unsigned int worker)
+	{
+		layout_arena&	   a   = _layout_arena;
+		const unsigned int end = a.subtree_end[i];
+
+		// Sibling subtrees only read their ancestors and write inside their own range, so big ones go to the pool and the parent's post pass waits for all of them.
+		if (_task_pool.get_worker_count() > 1 && end - i > _layout_task_min_entries)
+		{
+			const bool				  size_all = a.state[i] & layout_state::ls_size_all;
+			std::atomic<unsigned int> pending  = 0;
+
+			for (unsigned int c = i + 1; c < end; c = a.subtree_end[c])
+			{
+				if (!size_all && !(a.state[c] & (layout_state::ls_dirty | layout_state::ls_child_dirty))) continue;
+
+				if (a.subtree_end[c] - c >= _layout_task_min_entries)
+					_task_pool.push(worker, force ? &builder::layout_size_forced_task : &builder::layout_size_task, this, c, pending);
+				else
+					layout_size_subtree(c, force, worker);
+			}
+
+			_task_pool.wait(worker, pending);
+			return;
+		}
+
+		// Size passes run front to back over the visited part of the subtree and post passes back to front, so every widget aggregates children that already settled.
+		pod_vector<unsigned int>& posts = _reuse_layout_scratch[worker].posts;
+		const unsigned int		  first = posts.size();
+
+		for (unsigned int j = i + 1; j < end;)
+		{
+			if (!(a.state[a.parent[j]] & layout_state::ls_size_all) && !(a.state[j] & (layout_state::ls_dirty | layout_state::ls_child_dirty)))
+			{
+				j = a.subtree_end[j];
+				continue;
+			}
+
+			layout_size(j, force, worker);
+			posts.push_back(j);
+			j++;
+		}
+
+		for (unsigned int k = posts.size(); k > first; k--)
+			size_pass_post(posts[k - 1], worker);
+
+		posts.resize(first);
+	}
+
+	void builder::layout_pos_children(unsigned int i, unsigned int worker)
+	{
+		layout_arena&	   a   = _layout_arena;
+		const unsigned int end = a.subtree_end[i];
+
+		if (_task_pool.get_worker_count() > 1 && end - i > _layout_task_min_entries)
+		{
+			a.state[i] = (a.state[i] | layout_state::ls_positioned) & ~layout_state::ls_pos_pending;
+			layout_track(i, worker);
+			pos_pass_children(i, worker);
+
+			std::atomic<unsigned int> pending = 0;
+
+			for (unsigned int c = i + 1; c < end; c = a.subtree_end[c])
+			{
+				if (!(a.state[c] & layout_state::ls_pos_pending)) continue;
+
+				if (a.subtree_end[c] - c >= _layout_task_min_entries)
+					_task_pool.push(worker, &builder::layout_pos_task, this, c, pending);
+				else
+					layout_pos_children(c, worker);
+			}
+
+			_task_pool.wait(worker, pending);
+			return;
+		}
+
+		// Every widget resolves all of its children's positions before any of them is walked into, so a subtree only ever reads settled ancestors.
+		a.state[i] |= layout_state::ls_pos_pending;
+
+		for (unsigned int j = i; j < end;)
+		{
+			if (!(a.state[j] & layout_state::ls_pos_pending))
+			{
+				j = a.subtree_end[j];
+				continue;
+			}
+
+			a.state[j] = (a.state[j] | layout_state::ls_positioned) & ~layout_state::ls_pos_pending;
+			layout_track(j, worker);
+			pos_pass_children(j, worker);
+			j++;
+		}
+	}
+
+	void builder::layout_size_task(void* owner, unsigned int i, unsigned int worker)
+	{
+		static_cast<builder*>(owner)->layout_size_subtree(i, false, worker);
+	}
+
+	void builder::layout_size_forced_task(void* owner, unsigned int i, unsigned int worker)
+	{
+		static_cast<builder*>(owner)->layout_size_subtree(i, true, worker);
+	}
+
+	void builder::layout_pos_task(void* owner, unsigned int i, unsigned int worker)
+	{
+		static_cast<builder*>(owner)->layout_pos_children(i, worker);
+	}
+
+	void builder::pos_pass(unsigned int i)
+	{
+		layout_arena&	   a	 = _layout_arena;
+		pos_kernels::table[a.pos_kernel[i]](a, i);
+
+		if (a.hooks[i] & layout_hook::lh_pos_policy)
+		{
+			const layout_policy& policy = _layout_policies[a.pos_policy[i]];
+			policy.func(_widget_pool.get(a.slot[i]), policy.context);
+		}
+	}
+
+	void builder::pos_pass_children(unsigned int i, unsigned int worker)
+	{
+		layout_arena&			a			= _layout_arena;
+		const child_positioning positioning = a.positioning[i];
+		const float				spacing		= a.spacing[i];
+		const vec2				scroll		= a.scroll_offset[i];
+		float					child_x		= a.final_pos[i].x + a.margins[i].left;
+		float					child_y		= a.final_pos[i].y + a.margins[i].top;
+		const wrap_lines*		lines		= positioning == child_positioning::wrap ? &a.wraps[a.wrap[i]] : nullptr;
+		const grid_tracks*		tracks		= positioning == child_positioning::grid ? &a.grids[a.grid[i]] : nullptr;
+
+		// Child and line counters of wrap positioning, the child counter also picks grid cells.
+		unsigned int k = 0, line = 0;
+
+		for (unsigned int c = i + 1; c < a.subtree_end[i]; c = a.subtree_end[c], k++)
+		{
+			layout_track(c, worker);
+			pos_pass(c);
+
+			if (positioning == child_positioning::row)
+			{
+				a.final_pos[c].x = child_x;
+				child_x += spacing + a.final_size[c].x;
+			}
+			else if (positioning == child_positioning::column)
+			{
+				a.final_pos[c].y = child_y;
+				child_y += spacing + a.final_size[c].y;
+			}
+			else if (lines)
+			{
+				if (line < lines->starts.size() && lines->starts[line] == k)
+				{
+					if (line != 0) child_y += lines->heights[line - 1] + spacing;
+					child_x = a.final_pos[i].x + a.margins[i].left;
+					line++;
+				}
+
+				a.final_pos[c] = {child_x, child_y};
+				child_x += spacing + a.final_size[c].x;
+			}
+			else if (tracks)
+			{
+				const unsigned int columns = tracks->widths.size();
+				a.final_pos[c]			   = {child_x + tracks->column_offsets[k % columns], child_y + tracks->row_offsets[k / columns]};
+			}
+
+			a.final_pos[c] += scroll;
+
+			if ((a.state[c] & (layout_state::ls_dirty | layout_state::ls_child_dirty)) || a.prev_pos[c] != a.final_pos[c] || a.prev_size[c] != a.final_size[c]) a.state[c] |= layout_state::ls_pos_pending;
+		}
+	}
+
+	void builder::size_pass(unsigned int i, unsigned int worker)
+	{
+		layout_arena&	   a	 = _layout_arena;
+		const unsigned int p	 = a.parent[i];
+		vec2&			   size	 = a.final_size[i];
+		layout_scratch&	   stats = _reuse_layout_scratch[worker];
+
+		if (a.hooks[i] & layout_hook::lh_text)
+		{
+			// Only parent relative text depends on the parent size, keying the rest on it would remeasure every label on resize.
+			gfx_text&	   txt		 = _widget_pool.get(a.slot[i])->_widget_gfx.get_data<gfx_text>();
+			const bool	   relative	 = !math::equals(txt._parent_relative_scale, 0.0f, 0.001f);
+			const vec2	   available = relative && p != layout_arena::no_entry ? a.final_size[p] : vec2{};
+			const float	   scale	 = relative ? txt._parent_relative_scale : txt._scale;
+			measure_cache& mc		 = a.measures[i];
+
+			if (mc.revision == a.revision[i] && mc.available == available && mc.fnt == txt._font && mc.scale == scale)
+			{
+				size = mc.size;
+				stats.measure_hits++;
+				return;
+			}
+
+			size = builder::get_text_size(txt, available);
+			mc	 = {a.revision[i], available, {}, txt._font, scale, size};
+			stats.measure_misses++;
+			return;
+		}
+
+		size_kernels::table[a.size_kernel[i]](a, i);
+
+		if (a.hooks[i] & layout_hook::lh_size_policy)
+		{
+			const layout_policy& policy	   = _layout_policies[a.size_policy[i]];
+			const vec2			 available = p != layout_arena::no_entry ? a.final_size[p] : vec2{};
+			const vec2			 base	   = size;
+			measure_cache&		 mc		   = a.measures[i];
+
+			// Other policies may read anything, children included, and run every time like before.
+			const bool cached = policy.cacheable && !(a.state[i] & layout_state::ls_child_dirty);
+			if (cached && mc.revision == a.revision[i] && mc.available == available && mc.base == base)
+			{
+				size = mc.size;
+				stats.measure_hits++;
+				return;
+			}
+
+			policy.func(_widget_pool.get(a.slot[i]), policy.context);
+			mc = {a.revision[i], available, base, nullptr, 0.0f, size};
+			stats.measure_misses++;
+		}
+	}
+
+	void builder::size_pass_post(unsigned int i, unsigned int worker)
+	{
+		layout_arena&	   a	   = _layout_arena;
+		const unsigned int flags   = a.flags[i];
+		const unsigned int end	   = a.subtree_end[i];
+		const float		   spacing = a.spacing[i];
+		const margins&	   m	   = a.margins[i];
+		vec2&			   size	   = a.final_size[i];
+		const vec2		   sized   = size;
+
+		// Size policies run before the children they may read, one of them moving afterwards left the policy's result stale.
+		if (a.hooks[i] & layout_hook::lh_size_policy)
+		{
+			for (unsigned int c = i + 1; c < end; c = a.subtree_end[c])
+			{
+				if (!(a.state[c] & layout_state::ls_visited) || a.prev_size[c] == a.final_size[c]) continue;
+				_reuse_layout_scratch[worker].stale.push_back(i);
+				break;
+			}
+		}
+
+		// Tracks only depend on the cells, so they are settled before the grid sizes around them.
+		const unsigned int grid = a.grid[i];
+		if (grid != layout_arena::no_entry) size_grid(i);
+
+		/*
+			Max/Total behaviour.
+		*/
+		if (flags & widget_flags::wf_size_x_max_children)
+		{
+			size.x = m.left + m.right;
+
+			float max = 0.0f;
+
+			for (unsigned int c = i + 1; c < end; c = a.subtree_end[c])
+				max = math::max(a.final_size[c].x, max);
+
+			size.x += max;
+		}
+		else if (flags & widget_flags::wf_size_x_total_children && grid != layout_arena::no_entry)
+			size.x = m.left + m.right + a.grids[grid].extent.x;
+		else if (flags & widget_flags::wf_size_x_total_children)
+		{
+			size.x = m.left + m.right;
+			for (unsigned int c = i + 1; c < end; c = a.subtree_end[c])
+				size.x += a.final_size[c].x + spacing;
+			if (end != i + 1) size.x -= spacing;
+		}
+
+		// Lines break against the settled width and stack up into the height.
+		const unsigned int wrap = a.wrap[i];
+		if (wrap != layout_arena::no_entry) size_wrap(i);
+
+		if (flags & widget_flags::wf_size_y_max_children)
+		{
+			size.y = m.top + m.bottom;
+
+			float max = 0.0f;
+
+			for (unsigned int c = i + 1; c < end; c = a.subtree_end[c])
+				max = math::max(a.final_size[c].y, max);
+
+			size.y += max;
+		}
+		else if (flags & widget_flags::wf_size_y_total_children && wrap != layout_arena::no_entry)
+			size_wrap_height(i);
+		else if (flags & widget_flags::wf_size_y_total_children && grid != layout_arena::no_entry)
+			size.y = m.top + m.bottom + a.grids[grid].extent.y;
+		else if (flags & widget_flags::wf_size_y_total_children)
+		{
+			size.y = m.top + m.bottom;
+			for (unsigned int c = i + 1; c < end; c = a.subtree_end[c])
+				size.y += a.final_size[c].y + spacing;
+			if (end != i + 1) size.y -= spacing;
+		}
+
+		size_copy_check(i);
+		size_clamp(i);
+
+		// Children reading this size were sized before it settled, they are stale once it moved. Fill children are sized below against the settled one.
+		const bool moved_x = size.x != sized.x, moved_y = size.y != sized.y;
+		if (moved_x || moved_y)
+		{
+			pod_vector<unsigned int>& stale = _reuse_layout_scratch[worker].stale;
+			for (unsigned int c = i + 1; c < end; c = a.subtree_end[c])
+			{
+				const bool relative = (moved_x && (a.flags[c] & widget_flags::wf_size_x_relative)) || (moved_y && (a.flags[c] & widget_flags::wf_size_y_relative));
+				if (relative || ((a.hooks[c] & (layout_hook::lh_text | layout_hook::lh_size_policy)) && a.measures[c].available == sized)) stale.push_back(c);
+			}
+		}
+
+		/*
+			Expand/Fill behaviour.
+		*/
+		if (grid != layout_arena::no_entry)
+		{
+			// Fill cells stretch over their track instead of sharing the free space.
+			const grid_tracks& tracks  = a.grids[grid];
+			const unsigned int columns = tracks.widths.size();
+			pod_vector<vec2>&  sizes   = _reuse_layout_scratch[worker].flex_sizes;
+			const unsigned int first   = sizes.size();
+			bool			   filled  = false;
+			unsigned int	   k	   = 0;
+
+			for (unsigned int c = i + 1; c < end; c = a.subtree_end[c], k++)
+			{
+				vec2 cell = a.final_size[c];
+				if (a.flags[c] & widget_flags::wf_size_x_fill) cell.x = math::clamp(tracks.widths[k % columns], a.min_size[c].x, a.max_size[c].x);
+				if (a.flags[c] & widget_flags::wf_size_y_fill) cell.y = math::clamp(tracks.heights[k / columns], a.min_size[c].y, a.max_size[c].y);
+				filled |= cell != a.final_size[c];
+				sizes.push_back(cell);
+			}
+
+			if (filled) size_apply(i, first, worker);
+			sizes.resize(first);
+			return;
+		}
+
+		// Siblings only share overflow along the axis they are laid out on, across it every shrinkable child just has to fit the content on its own.
+		const child_positioning positioning = a.positioning[i];
+		const bool				main_x		= positioning == child_positioning::row;
+		const bool				main_y		= positioning == child_positioning::column;
+		const vec2				content		= {size.x - m.left - m.right, size.y - m.top - m.bottom};
+
+		float		 non_fill_total_x = -spacing, non_fill_total_y = -spacing;
+		unsigned int fill_count_x = 0, fill_count_y = 0;
+		bool		 shrinkable_x = false, shrinkable_y = false;
+		bool		 overflow_x = false, overflow_y = false;
+
+		for (unsigned int c = i + 1; c < end; c = a.subtree_end[c])
+		{
+			if (a.flags[c] & widget_flags::wf_size_x_fill) { fill_count_x++; }
+			else
+			{
+				non_fill_total_x += a.final_size[c].x + spacing;
+				shrinkable_x |= main_x && a.shrink[c].x > 0.0f;
+				overflow_x |= !main_x && a.shrink[c].x > 0.0f && a.final_size[c].x > content.x;
+			}
+
+			if (a.flags[c] & widget_flags::wf_size_y_fill) { fill_count_y++; }
+			else
+			{
+				non_fill_total_y += a.final_size[c].y + spacing;
+				shrinkable_y |= main_y && a.shrink[c].y > 0.0f;
+				overflow_y |= !main_y && a.shrink[c].y > 0.0f && a.final_size[c].y > content.y;
+			}
+		}
+
+		const bool flex_x = fill_count_x != 0 || (shrinkable_x && non_fill_total_x > size.x);
+		const bool flex_y = fill_count_y != 0 || (shrinkable_y && non_fill_total_y > size.y);
+		if (!flex_x && !flex_y && !overflow_x && !overflow_y) return;
+
+		pod_vector<vec2>&  sizes = _reuse_layout_scratch[worker].flex_sizes;
+		const unsigned int first = sizes.size();
+
+		for (unsigned int c = i + 1; c < end; c = a.subtree_end[c])
+			sizes.push_back(a.final_size[c]);
+
+		if (flex_x) size_flex(i, &vec2::x, widget_flags::wf_size_x_fill, non_fill_total_x, main_x, first, worker);
+		if (flex_y) size_flex(i, &vec2::y, widget_flags::wf_size_y_fill, non_fill_total_y, main_y, first, worker);
+
+		unsigned int k = first;
+		for (unsigned int c = i + 1; c < end && (overflow_x || overflow_y); c = a.subtree_end[c], k++)
+		{
+			if (overflow_x && !(a.flags[c] & widget_flags::wf_size_x_fill) && a.shrink[c].x > 0.0f && sizes[k].x > content.x) sizes[k].x = math::max(content.x, a.min_size[c].x);
+			if (overflow_y && !(a.flags[c] & widget_flags::wf_size_y_fill) && a.shrink[c].y > 0.0f && sizes[k].y > content.y) sizes[k].y = math::max(content.y, a.min_size[c].y);
+		}
+
+		size_apply(i, first, worker);
+		sizes.resize(first);
+
+		// Lines broke against the sizes children had before they were flexed, they break again against the settled ones. Unchanged lines are kept by the cache.
+		if (wrap != layout_arena::no_entry)
+		{
+			size_wrap(i);
+			if ((flags & widget_flags::wf_size_y_total_children) && !(flags & widget_flags::wf_size_y_max_children))
+			{
+				size_wrap_height(i);
+				size_clamp(i);
+			}
+		}
+	}
+
+	void builder::size_apply(unsigned int i, unsigned int first, unsigned int worker)
+	{
+		layout_arena&			a	  = _layout_arena;
+		const pod_vector<vec2>& sizes = _reuse_layout_scratch[worker].flex_sizes;
+		const unsigned int		end	  = a.subtree_end[i];
+
+		// A flexed child's subtree was sized against its previous size, so it is run again once that moves.
+		unsigned int k = first;
+		for (unsigned int c = i + 1; c < end; c = a.subtree_end[c], k++)
+		{
+			const vec2 child_size = sizes[k];
+			if (child_size == a.final_size[c]) continue;
+
+			layout_track(c, worker);
+			a.state[c] |= layout_state::ls_sized | layout_state::ls_size_all;
+			a.final_size[c] = child_size;
+			layout_size_children(c, true, worker);
+			size_pass_post(c, worker);
+		}
+	}
+
+	void builder::size_flex(unsigned int i, float vec2::*axis, unsigned int fill_flag, float fixed, bool shrink, unsigned int first, unsigned int worker)
+	{
+		layout_arena&		   a	 = _layout_arena;
+		pod_vector<vec2>&	   sizes = _reuse_layout_scratch[worker].flex_sizes;
+		pod_vector<flex_item>& items = _reuse_layout_scratch[worker].flex_items;
+		const unsigned int	   end	 = a.subtree_end[i];
+		const float			   free	 = a.final_size[i].*axis - fixed;
+
+		// Fill children grow from nothing when the free space exceeds their minimums and stay at their minimum otherwise, non fill children only ever shrink from their own size and only when shrink is set.
+		float fill_min = 0.0f;
+		for (unsigned int c = i + 1; c < end; c = a.subtree_end[c])
+		{
+			if (a.flags[c] & fill_flag) fill_min += math::clamp(0.0f, a.min_size[c].*axis, a.max_size[c].*axis);
+		}
+
+		const bool grow			= free > fill_min;
+		float	   frozen_delta = 0.0f;
+		items.resize(0);
+
+		for (unsigned int c = i + 1; c < end; c = a.subtree_end[c])
+		{
+			flex_item item = {};
+
+			if (a.flags[c] & fill_flag)
+			{
+				item.weight = grow ? a.grow[c].*axis : 0.0f;
+				item.frozen = item.weight <= 0.0f;
+				if (item.frozen)
+				{
+					item.target = math::clamp(0.0f, a.min_size[c].*axis, a.max_size[c].*axis);
+					frozen_delta += item.target;
+				}
+			}
+			else
+			{
+				item.base	= a.final_size[c].*axis;
+				item.target = item.base;
+				item.weight = grow || !shrink ? 0.0f : a.shrink[c].*axis * item.base;
+				item.frozen = item.weight <= 0.0f;
+			}
+
+			items.push_back(item);
+		}
+
+		// Clamp and redistribute, every round freezes at least one child at its min or max, so it ends after as many rounds as there are children at most.
+		while (true)
+		{
+			float weights = 0.0f;
+			for (const flex_item& item : items)
+			{
+				if (!item.frozen) weights += item.weight;
+			}
+
+			if (weights <= 0.0f) break;
+
+			const float	 remaining = free - frozen_delta;
+			float		 violation = 0.0f;
+			unsigned int k		   = 0;
+
+			for (unsigned int c = i + 1; c < end; c = a.subtree_end[c], k++)
+			{
+				flex_item& item = items[k];
+				if (item.frozen) continue;
+
+				item.unclamped = item.base + remaining * item.weight / weights;
+				item.target	   = math::clamp(item.unclamped, a.min_size[c].*axis, a.max_size[c].*axis);
+				violation += item.target - item.unclamped;
+			}
+
+			if (violation == 0.0f) break;
+
+			for (flex_item& item : items)
+			{
+				if (item.frozen) continue;
+				if ((violation > 0.0f && item.target > item.unclamped) || (violation < 0.0f && item.target < item.unclamped))
+				{
+					item.frozen = true;
+					frozen_delta += item.target - item.base;
+				}
+			}
+		}
+
+		for (unsigned int k = 0; k < items.size(); k++)
+			sizes[first + k].*axis = items[k].target;
+	}
+
+	void builder::size_copy_check(unsigned int i)
+	{
+		layout_arena&	   a	 = _layout_arena;
+		const unsigned int flags = a.flags[i];
+		vec2&			   size	 = a.final_size[i];
+
+		if (flags & widget_flags::wf_size_x_copy_y)
+			size.x = size.y * (flags & widget_flags::wf_size_x_relative ? a.size[i].x : 1.0f);
+		else if (flags & widget_flags::wf_size_y_copy_x)
+			size.y = size.x * (flags & widget_flags::wf_size_y_relative ? a.size[i].y : 1.0f);
+	}
+
+	void builder::size_wrap(unsigned int i)
+	{
+		layout_arena&	   a	   = _layout_arena;
+		wrap_lines&		   lines   = a.wraps[a.wrap[i]];
+		const unsigned int end	   = a.subtree_end[i];
+		const float		   spacing = a.spacing[i];
+		const float		   width   = a.final_size[i].x - a.margins[i].left - a.margins[i].right;
+
+		// Breaks only depend on the sequence of child sizes, so breaking resumes at the line holding the first child that differs from the cached sequence.
+		// A child opening a line also decided where the previous one ended, so that one is broken again too. Own changes like spacing bump the revision and
+		// break every line again.
+		unsigned int k = 0, line = 0, c = i + 1;
+
+		if (lines.revision == a.revision[i] && lines.width == width)
+		{
+			unsigned int line_entry = c, prev_line_entry = c;
+			for (; c < end; c = a.subtree_end[c], k++)
+			{
+				if (line < lines.starts.size() && lines.starts[line] == k)
+				{
+					prev_line_entry = line_entry;
+					line_entry		= c;
+					line++;
+				}
+
+				if (k == lines.sizes.size() || lines.sizes[k] != a.final_size[c]) break;
+			}
+
+			if (c == end && k == lines.sizes.size()) return;
+
+			if (line > 1 && lines.starts[line - 1] == k)
+			{
+				line -= 2;
+				c = prev_line_entry;
+			}
+			else if (line != 0)
+			{
+				line--;
+				c = line_entry;
+			}
+			else
+				c = i + 1;
+
+			k = line < lines.starts.size() ? lines.starts[line] : 0;
+		}
+
+		lines.revision = a.revision[i];
+		lines.width	   = width;
+		lines.starts.resize(line);
+		lines.heights.resize(line);
+		lines.sizes.resize(k);
+
+		float line_width = 0.0f;
+		bool  open		 = false;
+
+		for (; c < end; c = a.subtree_end[c], k++)
+		{
+			const vec2& child = a.final_size[c];
+
+			if (!open || line_width + spacing + child.x > width)
+			{
+				lines.starts.push_back(k);
+				lines.heights.push_back(0.0f);
+				line_width = child.x;
+				open	   = true;
+			}
+			else
+				line_width += spacing + child.x;
+
+			float& height = lines.heights[lines.heights.size() - 1];
+			height		  = math::max(height, child.y);
+			lines.sizes.push_back(child);
+		}
+	}
 
-		for (size_t i = 0; i < vertex_count; i++)
-			new (&_vertex_buffer[i]) vertex();
-		for (size_t i = 0; i < index_count; i++)
-			new (&_index_buffer[i]) index();
+	void builder::size_wrap_height(unsigned int i)
+	{
+		layout_arena&			 a		 = _layout_arena;
+		const pod_vector<float>& heights = a.wraps[a.wrap[i]].heights;
+		float&					 height	 = a.final_size[i].y;
+
+		height = a.margins[i].top + a.margins[i].bottom;
+		for (float h : heights)
+			height += h + a.spacing[i];
+		if (!heights.empty()) height -= a.spacing[i];
 	}
 
-	void builder::uninit()
+	void builder::size_grid(unsigned int i)
 	{
-		_widget_pool.clear();
+		layout_arena&	   a	   = _layout_arena;
+		grid_tracks&	   tracks  = a.grids[a.grid[i]];
+		const unsigned int end	   = a.subtree_end[i];
+		const float		   spacing = a.spacing[i];
+
+		unsigned int count = 0;
+		for (unsigned int c = i + 1; c < end; c = a.subtree_end[c])
+			count++;
+
+		const unsigned int columns = math::min(a.grid_columns[i], count);
+		const unsigned int rows	   = columns == 0 ? 0 : (count + columns - 1) / columns;
+		tracks.widths.resize(columns);
+		tracks.heights.resize(rows);
+		tracks.column_offsets.resize(columns);
+		tracks.row_offsets.resize(rows);
+
+		for (float& w : tracks.widths)
+			w = 0.0f;
+		for (float& h : tracks.heights)
+			h = 0.0f;
+
+		// Every track is as large as its largest cell, fill cells take the track size later so they do not count.
+		unsigned int k = 0;
+		for (unsigned int c = i + 1; c < end; c = a.subtree_end[c], k++)
+		{
+			const vec2& cell = a.final_size[c];
+			if (!(a.flags[c] & widget_flags::wf_size_x_fill)) tracks.widths[k % columns] = math::max(tracks.widths[k % columns], cell.x);
+			if (!(a.flags[c] & widget_flags::wf_size_y_fill)) tracks.heights[k / columns] = math::max(tracks.heights[k / columns], cell.y);
+		}
 
-		if (_vertex_buffer) FREE(_vertex_buffer);
-		if (_index_buffer) FREE(_index_buffer);
+		float offset = 0.0f;
+		for (unsigned int j = 0; j < columns; j++)
+		{
+			tracks.column_offsets[j] = offset;
+			offset += tracks.widths[j] + spacing;
+		}
+		tracks.extent.x = columns == 0 ? 0.0f : offset - spacing;
 
-		_vertex_buffer = nullptr;
-		_index_buffer  = nullptr;
+		offset = 0.0f;
+		for (unsigned int j = 0; j < rows; j++)
+		{
+			tracks.row_offsets[j] = offset;
+			offset += tracks.heights[j] + spacing;
+		}
+		tracks.extent.y = rows == 0 ? 0.0f : offset - spacing;
 	}
 
-	void builder::build(const vec2& screen_size)
+	void builder::size_clamp(unsigned int i)
 	{
-		ASSERT(_root);
-
-		_draw_buffers.resize(0);
-		_clip_stack.resize(0);
-		_buffer_counter = 0;
-
-		/* size & pos & draw */
-		_reuse_fill_x.resize(0);
-		_reuse_fill_y.resize(0);
-		builder& bd					   = *this;
-		_root->_widget_data.pos		   = {0.0f, 0.0f};
-		_root->_widget_data.size	   = screen_size;
-		_root->get_data_widget().flags = widget_flags::wf_pos_x_absolute | widget_flags::wf_pos_y_absolute | widget_flags::wf_size_x_absolute | widget_flags::wf_size_y_absolute;
-		_root->size_pass();
-		_root->size_pass_children(_reuse_fill_x, _reuse_fill_y);
-		_root->size_pass_post(_reuse_fill_x, _reuse_fill_y);
-		_root->pos_pass();
-		_root->pos_pass_children();
-		_root->pos_pass_post();
-
-		_root->draw_pass(bd);
-
-		_clip_stack.push_back({0.0f, 0.0f, screen_size.x, screen_size.y});
-		_root->draw_pass_children(bd);
-		_clip_stack.remove(_clip_stack.size() - 1);
+		layout_arena& a	   = _layout_arena;
+		vec2&		  size = a.final_size[i];
+		size.x			   = math::clamp(size.x, a.min_size[i].x, a.max_size[i].x);
+		size.y			   = math::clamp(size.y, a.min_size[i].y, a.max_size[i].y);
 	}
 
 	void builder::flush()
 	{
 		if (!_on_draw) return;
-		std::sort(_draw_buffers.begin(), _draw_buffers.end(), [](const draw_buffer& a, const draw_buffer& b) { return a.draw_order < b.draw_order; });
+		std::sort(_draw_buffers.begin(), _draw_buffers.end(), [](const draw_buffer& a, const draw_buffer& b) { return a.viewport != b.viewport ? a.viewport < b.viewport : a.draw_order < b.draw_order; });
+		_draw_buffer_table_dirty = true;
 
+		draw_stats& stats  = _draw_stats;
+		stats.peak_buffers = math::max(stats.peak_buffers, _draw_buffers.size());
 		for (draw_buffer& db : _draw_buffers)
+		{
+			stats.peak_vertices	 = math::max(stats.peak_vertices, db.vertex_count);
+			stats.peak_indices	 = math::max(stats.peak_indices, db.index_count);
+			stats.peak_instances = math::max(stats.peak_instances, db.instance_count);
 			_on_draw(db);
+		}
+		stats.reserved_bytes = _draw_arenas.vertices.get_reserved() + _draw_arenas.indices.get_reserved() + _draw_arenas.instances.get_reserved();
 	}
 
 	void builder::on_mouse_move(const vec2& mouse)
@@ -1826,10 +4192,25 @@ namespace vekt
 
 		for (widget* w : _press_state_history)
 		{
-			if (w->get_data_widget().on_mouse_dragged) w->get_data_widget().on_mouse_dragged(w, mouse, delta);
+			if (!w->get_data_widget().on_mouse_dragged) continue;
+			w->get_data_widget().on_mouse_dragged(w, mouse, delta);
+			_refresh = true;
 		}
 
+		_reuse_hovered.resize(0);
 		pass_hover_state(_root, mouse);
+
+		for (widget* w : _hovered)
+		{
+			if (!w->_is_hovered || _reuse_hovered.find(w) != _reuse_hovered.end()) continue;
+			if (w->get_data_widget().on_hover_end) w->get_data_widget().on_hover_end(w);
+			w->_is_hovered		   = false;
+			_layout_arena.redraw = true;
+		}
+
+		_hovered.resize(0);
+		for (widget* w : _reuse_hovered)
+			_hovered.push_back(w);
 	}
 
 	input_event_result builder::on_mouse_event(const mouse_event& ev)
@@ -1842,6 +4223,9 @@ namespace vekt
 			return input_event_result::not_handled;
 		}
 
+		// Callbacks may change drawn state the builder doesn't see, the next build compares its output.
+		_refresh = true;
+
 		widget* last_widget = nullptr;
 		for (const input_layer& layer : _input_layers)
 		{
@@ -1850,6 +4234,7 @@ namespace vekt
 				widget* w = find_widget_at(layer.root, _mouse_position);
 				if (w)
 				{
+					if (!w->_press_states[ev.button]) _layout_arena.redraw = true;
 					w->_press_states[ev.button] = true;
 					_press_state_history.push_back(w);
 				}
@@ -1863,11 +4248,15 @@ namespace vekt
 
 					if (w->_press_states[ev.button] && w->get_data_widget().on_mouse_clicked) { w->get_data_widget().on_mouse_clicked(w, ev); }
 
+					if (w->_press_states[ev.button]) _layout_arena.redraw = true;
 					w->_press_states[ev.button] = false;
 				}
 
 				for (widget* w : _press_state_history)
+				{
+					if (w->_press_states[ev.button]) _layout_arena.redraw = true;
 					w->_press_states[ev.button] = false;
+				}
 				_press_state_history.resize(0);
 			}
 
@@ -1888,6 +4277,9 @@ namespace vekt
 			return input_event_result::not_handled;
 		}
 
+		// Callbacks may change drawn state the builder doesn't see, the next build compares its output.
+		_refresh = true;
+
 		widget* last_widget = nullptr;
 		for (const input_layer& layer : _input_layers)
 		{
@@ -1908,6 +4300,9 @@ namespace vekt
 			return input_event_result::not_handled;
 		}
 
+		// Callbacks may change drawn state the builder doesn't see, the next build compares its output.
+		_refresh = true;
+
 		widget* last_widget = nullptr;
 		for (const input_layer& layer : _input_layers)
 		{
@@ -1949,44 +4344,94 @@ namespace vekt
 		V_ERR("vekt::remove_input_layer -> No input layer with the given priority exists! priority: %d", priority);
 	}
 
+	unsigned short builder::register_layout_policy(layout_policy_func func, void* context, bool cacheable)
+	{
+		ASSERT(func && _layout_policies.size() < 0xFFFF);
+		_layout_policies.push_back({func, context, cacheable});
+		return static_cast<unsigned short>(_layout_policies.size() - 1);
+	}
+
 	widget* builder::find_widget_at(widget* current_widget, const vec2& mouse)
 	{
-		if (!current_widget->get_is_visible()) { return nullptr; }
+		if (!current_widget->get_is_visible() || current_widget->_widget_gfx.opacity <= 0.0f) { return nullptr; }
+
+		// Subtree bounds are in the parent's space like the mouse, a miss skips every descendant.
+		if (!_layout_arena.bounds[current_widget->get_layout_index()].is_point_inside(mouse)) return nullptr;
 
-		const vec4 bounds = current_widget->get_clip_rect();
-		if (!bounds.is_point_inside(mouse)) return nullptr;
+		// Bring the mouse into the widget's untransformed layout space, a singular transform leaves nothing to hit.
+		vec2 local = mouse;
+		if (!current_widget->_widget_gfx.transform.is_identity())
+		{
+			affine inv = {};
+			if (!current_widget->get_transform_matrix().inverse(inv)) return nullptr;
+			local = inv.apply(mouse);
+		}
 
-		widget* found = nullptr;
+		const pod_vector<widget*>& children = current_widget->get_data_widget().children;
+		const bool				   sorted_x = _layout_arena.sorted_axis[current_widget->get_layout_index()] == sa_x;
+		unsigned int			   first = 0, last = 0;
+		get_child_range(current_widget, sorted_x ? local.x : local.y, sorted_x ? local.x : local.y, first, last);
 
-		for (widget* w : current_widget->get_data_widget().children)
+		for (unsigned int k = first; k < last; k++)
 		{
-			found = find_widget_at(w, mouse);
+			widget* found = find_widget_at(children[k], local);
 			if (found) return found;
 		}
 
-		return current_widget->get_data_widget().receive_input ? current_widget : nullptr;
+		return current_widget->get_data_widget().receive_input && current_widget->get_clip_rect().is_point_inside(local) ? current_widget : nullptr;
 	}
 
 	void builder::pass_hover_state(widget* w, const vec2& mouse)
 	{
+		// Nothing under a subtree the mouse misses can be hovered, widgets hovered last time are settled by on_mouse_move.
+		if (!_layout_arena.bounds[w->get_layout_index()].is_point_inside(mouse)) return;
+
+		// A singular transform has no area to hover, on_mouse_move ends the hover like for a miss.
+		vec2 local = mouse;
+		if (!w->_widget_gfx.transform.is_identity())
+		{
+			affine inv = {};
+			if (!w->get_transform_matrix().inverse(inv)) return;
+			local = inv.apply(mouse);
+		}
+
 		const vec4 clip	   = w->get_clip_rect();
-		const bool hovered = clip.is_point_inside(mouse);
+		const bool hovered = clip.is_point_inside(local);
 
 		if (w->get_data_widget().on_hover_end && w->_is_hovered && !hovered) w->get_data_widget().on_hover_end(w);
 		if (w->get_data_widget().on_hover_begin && !w->_is_hovered && hovered) w->get_data_widget().on_hover_begin(w);
+		if (w->_is_hovered != hovered) _layout_arena.redraw = true;
 		w->_is_hovered = hovered;
+		if (hovered) _reuse_hovered.push_back(w);
 
-		for (widget* c : w->get_data_widget().children)
-			pass_hover_state(c, mouse);
+		const pod_vector<widget*>& children = w->get_data_widget().children;
+		const bool				   sorted_x = _layout_arena.sorted_axis[w->get_layout_index()] == sa_x;
+		unsigned int			   first = 0, last = 0;
+		get_child_range(w, sorted_x ? local.x : local.y, sorted_x ? local.x : local.y, first, last);
+
+		for (unsigned int k = first; k < last; k++)
+			pass_hover_state(children[k], local);
 	}
 
-	void builder::add_filled_rect(const gfx_filled_rect& rect, const vec2& min, const vec2& max, unsigned int draw_order, void* user_data, bool use_hovered, bool use_pressed)
+	void builder::add_filled_rect(const gfx_filled_rect& rect, const vec2& min, const vec2& max, unsigned int draw_order, void* user_data, bool use_hovered, bool use_pressed, tessellation_cache* cache)
 	{
 		draw_buffer* db = get_draw_buffer(draw_order, user_data);
 
 		const vec4 color_start = (use_pressed && rect.pressed_color.w > 0.001f) ? rect.pressed_color : ((use_hovered && rect.hovered_color.w > 0.001f) ? rect.hovered_color : rect.color_start);
 		const vec4 color_end   = (use_pressed && rect.pressed_color.w > 0.001f) ? rect.pressed_color : ((use_hovered && rect.hovered_color.w > 0.001f) ? rect.hovered_color : rect.color_end);
 
+		if (_output_mode == output_mode::rect_instances)
+		{
+			add_rect_instance(db, min, max, color_start, color_end, rect.outline_color, rect.rounding, 0.0f, static_cast<float>(rect.outline_thickness), static_cast<float>(rect.aa_thickness), rect.color_direction, false);
+			return;
+		}
+
+		const int			   segments		= rect.rounding > 0.0f ? get_corner_segments(min, max, rect.rounding, rect.segments) : 0;
+		const tessellation_key key		   = {gfx_type::filled_rect, max - min, color_start, color_end, rect.outline_color, rect.rounding, static_cast<unsigned int>(segments), 0, rect.outline_thickness, rect.aa_thickness, rect.color_direction};
+		const unsigned int	   vertex_start = db->vertex_count;
+		const unsigned int	   index_start	= db->index_count;
+		if (begin_cached(db, cache, key, min)) return;
+
 		_reuse_outer_path.resize(0);
 		_reuse_outline_path.resize(0);
 
@@ -1995,7 +4440,7 @@ namespace vekt
 		const bool has_outline	= rect.outline_thickness > 0;
 
 		if (has_rounding)
-			generate_rounded_rect(_reuse_outer_path, min, max, rect.rounding, rect.segments);
+			generate_rounded_rect(_reuse_outer_path, min, max, rect.rounding, segments);
 		else
 			generate_sharp_rect(_reuse_outer_path, min, max);
 
@@ -2046,13 +4491,27 @@ namespace vekt
 			else
 				add_strip(db, out_aa_start, out_start, _reuse_aa_outer_path.size(), false);
 		}
+
+		end_cached(db, cache, key, min, vertex_start, index_start);
 	}
 
-	void builder::add_stroke_rect(const gfx_stroke_rect& rect, const vec2& min, const vec2& max, unsigned int draw_order, void* user_data, bool use_hovered, bool use_pressed)
+	void builder::add_stroke_rect(const gfx_stroke_rect& rect, const vec2& min, const vec2& max, unsigned int draw_order, void* user_data, bool use_hovered, bool use_pressed, tessellation_cache* cache)
 	{
 		draw_buffer* db			 = get_draw_buffer(draw_order, user_data);
 		const vec4	 color_start = (use_pressed && rect.pressed_color.w > 0.001f) ? rect.pressed_color : ((use_hovered && rect.hovered_color.w > 0.001f) ? rect.hovered_color : rect.color_start);
 		const vec4	 color_end	 = (use_pressed && rect.pressed_color.w > 0.001f) ? rect.pressed_color : ((use_hovered && rect.hovered_color.w > 0.001f) ? rect.hovered_color : rect.color_end);
+
+		if (_output_mode == output_mode::rect_instances)
+		{
+			add_rect_instance(db, min, max, color_start, color_end, {}, rect.rounding, static_cast<float>(rect.thickness), 0.0f, static_cast<float>(rect.aa_thickness), rect.color_direction, true);
+			return;
+		}
+
+		const int			   segments		= rect.rounding > 0.0f ? get_corner_segments(min, max, rect.rounding, rect.segments) : 0;
+		const tessellation_key key		   = {gfx_type::stroke_rect, max - min, color_start, color_end, {}, rect.rounding, static_cast<unsigned int>(segments), rect.thickness, 0, rect.aa_thickness, rect.color_direction};
+		const unsigned int	   vertex_start = db->vertex_count;
+		const unsigned int	   index_start	= db->index_count;
+		if (begin_cached(db, cache, key, min)) return;
 		_reuse_outer_path.resize(0);
 		_reuse_inner_path.resize(0);
 
@@ -2062,8 +4521,8 @@ namespace vekt
 
 		if (has_rounding)
 		{
-			generate_rounded_rect(_reuse_outer_path, min, max, rect.rounding, rect.segments);
-			generate_rounded_rect(_reuse_inner_path, min + vec2(rect.thickness, rect.thickness), max - vec2(rect.thickness, rect.thickness), rect.rounding, rect.segments);
+			generate_rounded_rect(_reuse_outer_path, min, max, rect.rounding, segments);
+			generate_rounded_rect(_reuse_inner_path, min + vec2(rect.thickness, rect.thickness), max - vec2(rect.thickness, rect.thickness), rect.rounding, segments);
 		}
 		else
 		{
@@ -2099,6 +4558,155 @@ namespace vekt
 			add_vertices_aa(db, _reuse_aa_inner_path, in_start, 0.0f, min, max);
 			add_strip(db, in_start, in_aa_start, _reuse_aa_inner_path.size(), false);
 		}
+
+		end_cached(db, cache, key, min, vertex_start, index_start);
+	}
+
+	namespace
+	{
+		// Writes pattern[i] + (pattern[i] < split ? lo : hi), so one relative pattern serves two vertex ranges that sit anywhere in the buffer.
+		// Bases are added in index width, a hi below split wraps around and still lands right.
+		void emit_indices(index* out, const index* pattern, unsigned int count, index split, index lo, index hi)
+		{
+			unsigned int i = 0;
+#ifdef VEKT_SSE2
+			const __m128i s	 = _mm_set1_epi16(static_cast<short>(split));
+			const __m128i lb = _mm_set1_epi16(static_cast<short>(lo));
+			const __m128i hb = _mm_set1_epi16(static_cast<short>(hi));
+			for (; i + 8 <= count; i += 8)
+			{
+				const __m128i t	   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern + i));
+				const __m128i mask = _mm_cmplt_epi16(t, s);
+				const __m128i base = _mm_or_si128(_mm_and_si128(mask, lb), _mm_andnot_si128(mask, hb));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_add_epi16(t, base));
+			}
+#endif
+			for (; i < count; i++)
+				out[i] = static_cast<index>(pattern[i] + (pattern[i] < split ? lo : hi));
+		}
+
+		constexpr index quad_pattern[6] = {0, 1, 3, 1, 2, 3};
+	}
+
+	void builder::add_rect_instance(draw_buffer* db, const vec2& min, const vec2& max, const vec4& color_start, const vec4& color_end, const vec4& outline_color, float rounding, float thickness, float outline_thickness, float aa_thickness, direction color_direction, bool is_stroke)
+	{
+		rect_instance& inst	  = db->add_get_instance();
+		inst.rect			  = {min.x, min.y, max.x - min.x, max.y - min.y};
+		inst.color_start	  = color_start;
+		inst.color_end		  = color_end;
+		inst.outline_color	  = outline_color;
+		inst.color_start.w	  *= _opacity;
+		inst.color_end.w	  *= _opacity;
+		inst.outline_color.w  *= _opacity;
+		inst.transform		  = _transform;
+		inst.rounding		  = math::min(rounding, math::min(inst.rect.z * 0.5f, inst.rect.w * 0.5f));
+		inst.thickness		  = thickness;
+		inst.outline_thickness = outline_thickness;
+		inst.aa_thickness	  = aa_thickness;
+		inst.color_direction  = static_cast<unsigned int>(color_direction);
+		inst.is_stroke		  = is_stroke ? 1 : 0;
+	}
+
+	vec4 rect_instance::evaluate(const vec2& screen_pos) const
+	{
+		affine inv = {};
+		if (!transform.inverse(inv)) return {};
+		const vec2 p = inv.apply(screen_pos);
+
+		// Signed distance to the rounded box, negative inside.
+		const vec2	half = {rect.z * 0.5f, rect.w * 0.5f};
+		const vec2	q	 = {std::fabs(p.x - rect.x - half.x) - half.x + rounding, std::fabs(p.y - rect.y - half.y) - half.y + rounding};
+		vec2		out	 = {math::max(q.x, 0.0f), math::max(q.y, 0.0f)};
+		const float d	 = out.mag() + math::min(math::max(q.x, q.y), 0.0f) - rounding;
+
+		const float ratio = color_direction == static_cast<unsigned int>(direction::vertical) ? (rect.w > 0.0f ? (p.y - rect.y) / rect.w : 0.0f) : (rect.z > 0.0f ? (p.x - rect.x) / rect.z : 0.0f);
+		const vec4	fill  = vec4::lerp(color_start, color_end, math::clamp(ratio, 0.0f, 1.0f));
+
+		// Inner and outer edge of the opaque band, and its color at the outer edge.
+		const float inner = is_stroke ? -thickness : -FLT_MAX;
+		const float outer = is_stroke ? 0.0f : outline_thickness;
+		const vec4	edge  = (!is_stroke && outline_thickness > 0.0f) ? outline_color : fill;
+
+		vec4 color = {};
+		if (d >= inner && d <= 0.0f)
+			color = fill;
+		else if (d > 0.0f && d <= outer)
+			color = outline_color;
+		else if (d > outer && d < outer + aa_thickness)
+		{
+			color = edge;
+			color.w *= 1.0f - (d - outer) / aa_thickness;
+		}
+		else if (d < inner && d > inner - aa_thickness)
+		{
+			color = fill;
+			color.w *= 1.0f - (inner - d) / aa_thickness;
+		}
+		return color;
+	}
+
+	bool builder::begin_cached(draw_buffer* db, tessellation_cache* cache, const tessellation_key& key, const vec2& min)
+	{
+		if (!cache) return false;
+
+		if (cache->key == key)
+		{
+			add_cached(db, *cache, min);
+			return true;
+		}
+
+		// Generate untransformed at full opacity so the result can be stored, end_cached() restores both and emits it like a hit.
+		_cached_transform = _transform;
+		_cached_opacity	  = _opacity;
+		_transform		  = {};
+		_opacity		  = 1.0f;
+		return false;
+	}
+
+	void builder::end_cached(draw_buffer* db, tessellation_cache* cache, const tessellation_key& key, const vec2& min, unsigned int vertex_start, unsigned int index_start)
+	{
+		if (!cache) return;
+
+		_transform = _cached_transform;
+		_opacity   = _cached_opacity;
+
+		const unsigned int vertex_count = db->vertex_count - vertex_start;
+		const unsigned int index_count	= db->index_count - index_start;
+		cache->key						= key;
+		cache->vertices.resize(vertex_count);
+		cache->indices.resize(index_count);
+
+		for (unsigned int i = 0; i < vertex_count; i++)
+		{
+			cache->vertices[i]	   = db->vertex_start[vertex_start + i];
+			cache->vertices[i].pos = cache->vertices[i].pos - min;
+		}
+
+		for (unsigned int i = 0; i < index_count; i++)
+			cache->indices[i] = db->index_start[index_start + i] - vertex_start;
+
+		db->vertex_count = vertex_start;
+		db->index_count	 = index_start;
+		add_cached(db, *cache, min);
+	}
+
+	void builder::add_cached(draw_buffer* db, const tessellation_cache& cache, const vec2& min)
+	{
+		const unsigned int start	   = db->vertex_count;
+		const bool		   transformed = !_transform.is_identity();
+
+		vertex*			   out		   = db->add_get_vertices(cache.vertices.size());
+
+		for (const vertex& v : cache.vertices)
+		{
+			vertex& vtx = *out++;
+			vtx			= v;
+			vtx.pos		= v.pos + min;
+			vtx.color.w *= _opacity;
+			if (transformed) vtx.pos = _transform.apply(vtx.pos);
+		}
+
+		emit_indices(db->add_get_indices(cache.indices.size()), cache.indices.data(), cache.indices.size(), 0, static_cast<index>(start), static_cast<index>(start));
 	}
 
 	void builder::add_text(const gfx_text& text, const vec2& position, const vec2& size, unsigned int draw_order, void* user_data, bool use_hovered, bool use_pressed)
@@ -2122,8 +4730,9 @@ namespace vekt
 		unsigned int vtx_counter = 0;
 		unsigned int idx_counter = 0;
 
-		vec2	   pen = position;
-		const vec2 end = pen + size;
+		vec2	   pen		   = position;
+		const vec2 end		   = pen + size;
+		const bool transformed = !_transform.is_identity();
 
 		auto draw_char = [&](const glyph& g, unsigned long c, unsigned long previous_char) {
 			if (previous_char != 0)
@@ -2137,10 +4746,11 @@ namespace vekt
 			const float quad_right	= quad_left + g.width * text._scale;
 			const float quad_bottom = quad_top + g.height * text._scale;
 
-			vertex& v0 = db->add_get_vertex();
-			vertex& v1 = db->add_get_vertex();
-			vertex& v2 = db->add_get_vertex();
-			vertex& v3 = db->add_get_vertex();
+			vertex* quad = db->add_get_vertices(4);
+			vertex& v0	 = quad[0];
+			vertex& v1	 = quad[1];
+			vertex& v2	 = quad[2];
+			vertex& v3	 = quad[3];
 
 			v0.pos = {quad_left, quad_top};
 			v1.pos = {quad_right, quad_top};
@@ -2151,6 +4761,7 @@ namespace vekt
 				const float x0 = math::remap(vtx.pos.x, position.x, end.x, 0.0f, 1.0f);
 				const float y0 = math::remap(vtx.pos.y, position.y, end.y, 0.0f, 1.0f);
 				vtx.color	   = text.color_direction == direction::horizontal ? vec4::lerp(color_start, color_end, x0) : vec4::lerp(color_start, color_end, y0);
+				vtx.color.w *= _opacity;
 			};
 
 			set_col(v0);
@@ -2158,6 +4769,14 @@ namespace vekt
 			set_col(v2);
 			set_col(v3);
 
+			if (transformed)
+			{
+				v0.pos = _transform.apply(v0.pos);
+				v1.pos = _transform.apply(v1.pos);
+				v2.pos = _transform.apply(v2.pos);
+				v3.pos = _transform.apply(v3.pos);
+			}
+
 			v0.uv = vec2(g.uv_x, g.uv_y);
 			v1.uv = v0.uv + vec2(g.uv_w, 0.0f);
 			v2.uv = v1.uv + vec2(0.0f, g.uv_h);
@@ -2242,76 +4861,317 @@ namespace vekt
 		return vec2(total_x - text.spacing * used_scale, max_y);
 	}
 
-	void builder::add_strip(draw_buffer* db, unsigned int outer_start, unsigned int inner_start, unsigned int size, bool add_ccw)
+	const pod_vector<index>& builder::get_index_pattern(pod_vector<pod_vector<index>>& patterns, unsigned int size, bool fan, bool ccw)
 	{
+		if (patterns.size() <= size) patterns.resize(size + 1);
+
+		pod_vector<index>& pattern = patterns[size];
+		if (!pattern.empty() || size == 0) return pattern;
+
+		// First ring or the path is [0, size), the second ring or the central vertex is at size.
 		for (unsigned int i = 0; i < size; i++)
 		{
-			const unsigned int p1_curr = outer_start + i;
-			const unsigned int p1_next = outer_start + (i + 1) % size;
-			const unsigned int p2_curr = inner_start + i;
-			const unsigned int p2_next = inner_start + (i + 1) % size;
-			db->add_index(p1_curr);
+			const index curr = static_cast<index>(i);
+			const index next = static_cast<index>((i + 1) % size);
 
-			if (add_ccw)
-			{
-				db->add_index(p2_curr);
-				db->add_index(p1_next);
-			}
-			else
+			if (fan)
 			{
-				db->add_index(p1_next);
-				db->add_index(p2_curr);
+				pattern.push_back(static_cast<index>(size));
+				pattern.push_back(curr);
+				pattern.push_back(next);
+				continue;
 			}
 
-			db->add_index(p1_next);
-			if (add_ccw)
-			{
-				db->add_index(p2_curr);
-				db->add_index(p2_next);
-			}
-			else
-			{
-				db->add_index(p2_next);
-				db->add_index(p2_curr);
-			}
+			const index inner_curr = static_cast<index>(size + curr);
+			const index inner_next = static_cast<index>(size + next);
+			pattern.push_back(curr);
+			pattern.push_back(ccw ? inner_curr : next);
+			pattern.push_back(ccw ? next : inner_curr);
+			pattern.push_back(next);
+			pattern.push_back(ccw ? inner_curr : inner_next);
+			pattern.push_back(ccw ? inner_next : inner_curr);
 		}
+
+		return pattern;
+	}
+
+	void builder::add_strip(draw_buffer* db, unsigned int outer_start, unsigned int inner_start, unsigned int size, bool add_ccw)
+	{
+		const pod_vector<index>& pattern = get_index_pattern(add_ccw ? _strip_patterns_ccw : _strip_patterns, size, false, add_ccw);
+		emit_indices(db->add_get_indices(pattern.size()), pattern.data(), pattern.size(), static_cast<index>(size), static_cast<index>(outer_start), static_cast<index>(inner_start - size));
 	}
 
 	void builder::add_filled_rect(draw_buffer* db, unsigned int start, unsigned int size)
 	{
 		if (size != 4) return;
-
-		db->add_index(start);
-		db->add_index(start + 1);
-		db->add_index(start + 3);
-		db->add_index(start + 1);
-		db->add_index(start + 2);
-		db->add_index(start + 3);
+		emit_indices(db->add_get_indices(6), quad_pattern, 6, 4, static_cast<index>(start), static_cast<index>(start));
 	}
 
 	void builder::add_filled_rect_central(draw_buffer* db, unsigned int start, unsigned int central_start, unsigned int size)
 	{
-		for (unsigned int i = 0; i < size; i++)
+		const pod_vector<index>& pattern = get_index_pattern(_fan_patterns, size, true, false);
+		emit_indices(db->add_get_indices(pattern.size()), pattern.data(), pattern.size(), static_cast<index>(size), static_cast<index>(start), static_cast<index>(central_start - size));
+	}
+
+	namespace
+	{
+		static_assert(sizeof(vertex) == sizeof(float) * 8, "vertex emission kernels expect pos, uv and color packed back to back");
+
+#ifdef VEKT_AVX2
+		bool get_has_avx2()
+		{
+			static const bool has_avx2 = [] {
+#if defined(_MSC_VER) && !defined(__clang__)
+				int info[4];
+				__cpuid(info, 0);
+				if (info[0] < 7) return false;
+
+				// The OS has to save ymm registers too, not only the CPU support them.
+				__cpuid(info, 1);
+				const bool osxsave = info[2] & (1 << 27), avx = info[2] & (1 << 28);
+				if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+
+				__cpuidex(info, 7, 0);
+				return (info[1] & (1 << 5)) != 0;
+#else
+				return __builtin_cpu_supports("avx2") != 0;
+#endif
+			}();
+			return has_avx2;
+		}
+
+		// Four vertices per iteration, one ymm register each. Multiplies and adds stay separate so results match the SSE2 and scalar paths bit for bit.
+		// Returns how many vertices were written, the callers finish the rest.
+		template <bool Vertical, bool Transformed>
+		VEKT_TARGET_AVX2 unsigned int emit_vertices_avx2(vertex* out, const vec2* path, unsigned int count, const vec2& min, const vec2& inv_extent, const vec4& color_start, const vec4& color_delta, const affine& tr)
+		{
+			const __m256  mn	= _mm256_setr_ps(min.x, min.y, min.x, min.y, min.x, min.y, min.x, min.y);
+			const __m256  inv	= _mm256_setr_ps(inv_extent.x, inv_extent.y, inv_extent.x, inv_extent.y, inv_extent.x, inv_extent.y, inv_extent.x, inv_extent.y);
+			const __m256  cs	= _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&color_start.x));
+			const __m256  cd	= _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&color_delta.x));
+			const __m256  tr_ab = _mm256_setr_ps(tr.a, tr.b, tr.a, tr.b, tr.a, tr.b, tr.a, tr.b);
+			const __m256  tr_cd = _mm256_setr_ps(tr.c, tr.d, tr.c, tr.d, tr.c, tr.d, tr.c, tr.d);
+			const __m256  tr_t	= _mm256_setr_ps(tr.tx, tr.ty, tr.tx, tr.ty, tr.tx, tr.ty, tr.tx, tr.ty);
+			const __m256  r_mn	= _mm256_set1_ps(Vertical ? min.y : min.x);
+			const __m256  r_inv = _mm256_set1_ps(Vertical ? inv_extent.y : inv_extent.x);
+
+			unsigned int i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				const __m256 p	= _mm256_loadu_ps(&path[i].x);
+				const __m256 uv = _mm256_mul_ps(_mm256_sub_ps(p, mn), inv);
+
+				__m256 pos = p;
+				if constexpr (Transformed)
+				{
+					const __m256 xx = _mm256_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 0, 0));
+					const __m256 yy = _mm256_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 1, 1));
+					pos				= _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(xx, tr_ab), _mm256_mul_ps(yy, tr_cd)), tr_t);
+				}
+
+				// Pairs of floats move as doubles: lo holds pos and uv of vertices 0 and 2, hi those of 1 and 3.
+				const __m256 lo	 = _mm256_castpd_ps(_mm256_unpacklo_pd(_mm256_castps_pd(pos), _mm256_castps_pd(uv)));
+				const __m256 hi	 = _mm256_castpd_ps(_mm256_unpackhi_pd(_mm256_castps_pd(pos), _mm256_castps_pd(uv)));
+
+				// Ratios are broadcast from memory and blended rather than shuffled out of uv, the shuffle port is already the bottleneck.
+				const float* axis = Vertical ? &path[i].y : &path[i].x;
+				const __m256 p01  = _mm256_blend_ps(_mm256_broadcast_ss(axis), _mm256_broadcast_ss(axis + 2), 0xF0);
+				const __m256 p23  = _mm256_blend_ps(_mm256_broadcast_ss(axis + 4), _mm256_broadcast_ss(axis + 6), 0xF0);
+				const __m256 c01  = _mm256_add_ps(cs, _mm256_mul_ps(cd, _mm256_mul_ps(_mm256_sub_ps(p01, r_mn), r_inv)));
+				const __m256 c23  = _mm256_add_ps(cs, _mm256_mul_ps(cd, _mm256_mul_ps(_mm256_sub_ps(p23, r_mn), r_inv)));
+
+				_mm256_storeu_ps(&out[i].pos.x, _mm256_permute2f128_ps(lo, c01, 0x20));
+				_mm256_storeu_ps(&out[i + 1].pos.x, _mm256_permute2f128_ps(hi, c01, 0x30));
+				_mm256_storeu_ps(&out[i + 2].pos.x, _mm256_permute2f128_ps(lo, c23, 0x21));
+				_mm256_storeu_ps(&out[i + 3].pos.x, _mm256_permute2f128_ps(hi, c23, 0x31));
+			}
+
+			return i;
+		}
+
+		template <bool Transformed>
+		VEKT_TARGET_AVX2 unsigned int emit_vertices_aa_avx2(vertex* out, const vec2* path, const vertex* colors, unsigned int count, const vec2& min, const vec2& inv_extent, float alpha, const affine& tr)
+		{
+			const __m256 mn	   = _mm256_setr_ps(min.x, min.y, min.x, min.y, min.x, min.y, min.x, min.y);
+			const __m256 inv   = _mm256_setr_ps(inv_extent.x, inv_extent.y, inv_extent.x, inv_extent.y, inv_extent.x, inv_extent.y, inv_extent.x, inv_extent.y);
+			const __m256 rgb   = _mm256_castsi256_ps(_mm256_setr_epi32(-1, -1, -1, 0, -1, -1, -1, 0));
+			const __m256 a	   = _mm256_setr_ps(0.0f, 0.0f, 0.0f, alpha, 0.0f, 0.0f, 0.0f, alpha);
+			const __m256 tr_ab = _mm256_setr_ps(tr.a, tr.b, tr.a, tr.b, tr.a, tr.b, tr.a, tr.b);
+			const __m256 tr_cd = _mm256_setr_ps(tr.c, tr.d, tr.c, tr.d, tr.c, tr.d, tr.c, tr.d);
+			const __m256 tr_t  = _mm256_setr_ps(tr.tx, tr.ty, tr.tx, tr.ty, tr.tx, tr.ty, tr.tx, tr.ty);
+
+			unsigned int i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				const __m256 p	= _mm256_loadu_ps(&path[i].x);
+				const __m256 uv = _mm256_mul_ps(_mm256_sub_ps(p, mn), inv);
+
+				__m256 pos = p;
+				if constexpr (Transformed)
+				{
+					const __m256 xx = _mm256_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 0, 0));
+					const __m256 yy = _mm256_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 1, 1));
+					pos				= _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(xx, tr_ab), _mm256_mul_ps(yy, tr_cd)), tr_t);
+				}
+
+				const __m256 lo	 = _mm256_castpd_ps(_mm256_unpacklo_pd(_mm256_castps_pd(pos), _mm256_castps_pd(uv)));
+				const __m256 hi	 = _mm256_castpd_ps(_mm256_unpackhi_pd(_mm256_castps_pd(pos), _mm256_castps_pd(uv)));
+				const __m256 c01 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&colors[i].color.x)), _mm_loadu_ps(&colors[i + 1].color.x), 1);
+				const __m256 c23 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&colors[i + 2].color.x)), _mm_loadu_ps(&colors[i + 3].color.x), 1);
+				const __m256 a01 = _mm256_or_ps(_mm256_and_ps(c01, rgb), a);
+				const __m256 a23 = _mm256_or_ps(_mm256_and_ps(c23, rgb), a);
+
+				_mm256_storeu_ps(&out[i].pos.x, _mm256_permute2f128_ps(lo, a01, 0x20));
+				_mm256_storeu_ps(&out[i + 1].pos.x, _mm256_permute2f128_ps(hi, a01, 0x30));
+				_mm256_storeu_ps(&out[i + 2].pos.x, _mm256_permute2f128_ps(lo, a23, 0x21));
+				_mm256_storeu_ps(&out[i + 3].pos.x, _mm256_permute2f128_ps(hi, a23, 0x31));
+			}
+
+			return i;
+		}
+#endif
+
+		// Both kernels write four vertices at a time with AVX2 when the CPU has it and pairs with SSE2, the scalar loop handles the tail or everything without either.
+		template <bool Vertical, bool Transformed>
+		void emit_vertices(vertex* out, const vec2* path, unsigned int count, const vec2& min, const vec2& inv_extent, const vec4& color_start, const vec4& color_delta, const affine& tr)
+		{
+			unsigned int i = 0;
+#ifdef VEKT_AVX2
+			if (get_has_avx2()) i = emit_vertices_avx2<Vertical, Transformed>(out, path, count, min, inv_extent, color_start, color_delta, tr);
+#endif
+#ifdef VEKT_SSE2
+			const __m128 mn	   = _mm_setr_ps(min.x, min.y, min.x, min.y);
+			const __m128 inv   = _mm_setr_ps(inv_extent.x, inv_extent.y, inv_extent.x, inv_extent.y);
+			const __m128 cs	   = _mm_loadu_ps(&color_start.x);
+			const __m128 cd	   = _mm_loadu_ps(&color_delta.x);
+			const __m128 tr_ab = _mm_setr_ps(tr.a, tr.b, tr.a, tr.b);
+			const __m128 tr_cd = _mm_setr_ps(tr.c, tr.d, tr.c, tr.d);
+			const __m128 tr_t  = _mm_setr_ps(tr.tx, tr.ty, tr.tx, tr.ty);
+
+			for (; i + 2 <= count; i += 2)
+			{
+				const __m128 p	= _mm_loadu_ps(&path[i].x);
+				const __m128 uv = _mm_mul_ps(_mm_sub_ps(p, mn), inv);
+				__m128		 r0, r1;
+				if constexpr (Vertical)
+				{
+					r0 = _mm_shuffle_ps(uv, uv, _MM_SHUFFLE(1, 1, 1, 1));
+					r1 = _mm_shuffle_ps(uv, uv, _MM_SHUFFLE(3, 3, 3, 3));
+				}
+				else
+				{
+					r0 = _mm_shuffle_ps(uv, uv, _MM_SHUFFLE(0, 0, 0, 0));
+					r1 = _mm_shuffle_ps(uv, uv, _MM_SHUFFLE(2, 2, 2, 2));
+				}
+
+				__m128 pos = p;
+				if constexpr (Transformed)
+				{
+					const __m128 xx = _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 0, 0));
+					const __m128 yy = _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 1, 1));
+					pos				= _mm_add_ps(_mm_add_ps(_mm_mul_ps(xx, tr_ab), _mm_mul_ps(yy, tr_cd)), tr_t);
+				}
+
+				_mm_storeu_ps(&out[i].pos.x, _mm_movelh_ps(pos, uv));
+				_mm_storeu_ps(&out[i].color.x, _mm_add_ps(cs, _mm_mul_ps(cd, r0)));
+				_mm_storeu_ps(&out[i + 1].pos.x, _mm_movehl_ps(uv, pos));
+				_mm_storeu_ps(&out[i + 1].color.x, _mm_add_ps(cs, _mm_mul_ps(cd, r1)));
+			}
+#endif
+			for (; i < count; i++)
+			{
+				vertex&		vtx	  = out[i];
+				const vec2& p	  = path[i];
+				vtx.uv			  = {(p.x - min.x) * inv_extent.x, (p.y - min.y) * inv_extent.y};
+				const float ratio = Vertical ? vtx.uv.y : vtx.uv.x;
+				vtx.color		  = color_start + color_delta * ratio;
+				if constexpr (Transformed)
+					vtx.pos = tr.apply(p);
+				else
+					vtx.pos = p;
+			}
+		}
+
+		template <bool Transformed>
+		void emit_vertices_aa(vertex* out, const vec2* path, const vertex* colors, unsigned int count, const vec2& min, const vec2& inv_extent, float alpha, const affine& tr)
 		{
-			db->add_index(central_start);
-			db->add_index(start + i);
-			db->add_index(start + ((i + 1) % (size)));
+			unsigned int i = 0;
+#ifdef VEKT_AVX2
+			if (get_has_avx2()) i = emit_vertices_aa_avx2<Transformed>(out, path, colors, count, min, inv_extent, alpha, tr);
+#endif
+#ifdef VEKT_SSE2
+			const __m128 mn	   = _mm_setr_ps(min.x, min.y, min.x, min.y);
+			const __m128 inv   = _mm_setr_ps(inv_extent.x, inv_extent.y, inv_extent.x, inv_extent.y);
+			const __m128 rgb   = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+			const __m128 a	   = _mm_setr_ps(0.0f, 0.0f, 0.0f, alpha);
+			const __m128 tr_ab = _mm_setr_ps(tr.a, tr.b, tr.a, tr.b);
+			const __m128 tr_cd = _mm_setr_ps(tr.c, tr.d, tr.c, tr.d);
+			const __m128 tr_t  = _mm_setr_ps(tr.tx, tr.ty, tr.tx, tr.ty);
+
+			for (; i + 2 <= count; i += 2)
+			{
+				const __m128 p	= _mm_loadu_ps(&path[i].x);
+				const __m128 uv = _mm_mul_ps(_mm_sub_ps(p, mn), inv);
+
+				__m128 pos = p;
+				if constexpr (Transformed)
+				{
+					const __m128 xx = _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 0, 0));
+					const __m128 yy = _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 1, 1));
+					pos				= _mm_add_ps(_mm_add_ps(_mm_mul_ps(xx, tr_ab), _mm_mul_ps(yy, tr_cd)), tr_t);
+				}
+
+				_mm_storeu_ps(&out[i].pos.x, _mm_movelh_ps(pos, uv));
+				_mm_storeu_ps(&out[i].color.x, _mm_or_ps(_mm_and_ps(_mm_loadu_ps(&colors[i].color.x), rgb), a));
+				_mm_storeu_ps(&out[i + 1].pos.x, _mm_movehl_ps(uv, pos));
+				_mm_storeu_ps(&out[i + 1].color.x, _mm_or_ps(_mm_and_ps(_mm_loadu_ps(&colors[i + 1].color.x), rgb), a));
+			}
+#endif
+			for (; i < count; i++)
+			{
+				vertex&		vtx = out[i];
+				const vec2& p	= path[i];
+				vtx.uv			= {(p.x - min.x) * inv_extent.x, (p.y - min.y) * inv_extent.y};
+				vtx.color		= colors[i].color;
+				vtx.color.w		= alpha;
+				if constexpr (Transformed)
+					vtx.pos = tr.apply(p);
+				else
+					vtx.pos = p;
+			}
 		}
 	}
 
 	void builder::add_vertices_aa(draw_buffer* db, const pod_vector<vec2>& path, unsigned int original_vertices_idx, float alpha, const vec2& min, const vec2& max)
 	{
-		const unsigned int start_vtx_idx = db->vertex_count;
+		const unsigned int count = path.size();
+		const vec2		   inv	 = {1.0f / (max.x - min.x), 1.0f / (max.y - min.y)};
+		vertex*			   out	 = db->add_get_vertices(count);
+		const vertex*	   src	 = db->vertex_start + original_vertices_idx;
 
-		for (unsigned int i = 0; i < path.size(); i++)
-		{
-			vertex& vtx = db->add_get_vertex();
-			vtx.pos		= path[i];
-			vtx.color	= db->vertex_start[original_vertices_idx + i].color;
-			vtx.color.w = alpha;
-			vtx.uv.x	= math::remap(vtx.pos.x, min.x, max.x, 0.0f, 1.0f);
-			vtx.uv.y	= math::remap(vtx.pos.y, min.y, max.y, 0.0f, 1.0f);
-		}
+		if (_transform.is_identity())
+			emit_vertices_aa<false>(out, path.data(), src, count, min, inv, alpha * _opacity, _transform);
+		else
+			emit_vertices_aa<true>(out, path.data(), src, count, min, inv, alpha * _opacity, _transform);
+	}
+
+	void builder::add_vertices(draw_buffer* db, const pod_vector<vec2>& path, const vec4& color_start, const vec4& color_end, direction direction, const vec2& min, const vec2& max)
+	{
+		const unsigned int count = path.size();
+		const vec2		   inv	 = {1.0f / (max.x - min.x), 1.0f / (max.y - min.y)};
+		vertex*			   out	 = db->add_get_vertices(count);
+
+		vec4 start = color_start;
+		vec4 delta = color_end - color_start;
+		start.w *= _opacity;
+		delta.w *= _opacity;
+
+		const bool vertical	   = direction == direction::vertical;
+		const bool transformed = !_transform.is_identity();
+		if (vertical)
+			transformed ? emit_vertices<true, true>(out, path.data(), count, min, inv, start, delta, _transform) : emit_vertices<true, false>(out, path.data(), count, min, inv, start, delta, _transform);
+		else
+			transformed ? emit_vertices<false, true>(out, path.data(), count, min, inv, start, delta, _transform) : emit_vertices<false, false>(out, path.data(), count, min, inv, start, delta, _transform);
 	}
 
 	namespace
@@ -2357,30 +5217,12 @@ namespace vekt
 
 	void builder::generate_offset_rounded_rect(pod_vector<vec2>& out_path, const pod_vector<vec2>& base_path, float amount) {}
 
-	void builder::add_vertices(draw_buffer* db, const pod_vector<vec2>& path, const vec4& color_start, const vec4& color_end, direction direction, const vec2& min, const vec2& max)
-	{
-		const unsigned int start_vtx_idx = db->vertex_count;
-
-		for (unsigned int i = 0; i < path.size(); i++)
-		{
-			vertex& vtx = db->add_get_vertex();
-			vtx.pos		= path[i];
-
-			const float ratio = direction == direction::horizontal ? math::remap(vtx.pos.x, min.x, max.x, 0.0f, 1.0f) : math::remap(vtx.pos.y, min.y, max.y, 0.0f, 1.0f);
-			vtx.color.x		  = math::lerp(color_start.x, color_end.x, ratio);
-			vtx.color.y		  = math::lerp(color_start.y, color_end.y, ratio);
-			vtx.color.z		  = math::lerp(color_start.z, color_end.z, ratio);
-			vtx.color.w		  = math::lerp(color_start.w, color_end.w, ratio);
-			vtx.uv.x		  = math::remap(vtx.pos.x, min.x, max.x, 0.0f, 1.0f);
-			vtx.uv.y		  = math::remap(vtx.pos.y, min.y, max.y, 0.0f, 1.0f);
-		}
-	}
-
 	void builder::add_central_vertex(draw_buffer* db, const vec4& color_start, const vec4& color_end, const vec2& min, const vec2& max)
 	{
 		vertex& vtx = db->add_get_vertex();
-		vtx.pos		= (min + max) * 0.5f;
+		vtx.pos		= _transform.apply((min + max) * 0.5f);
 		vtx.color	= (color_start + color_end) * 0.5f;
+		vtx.color.w *= _opacity;
 		vtx.uv		= vec2(0.5f, 0.5f);
 	}
 
@@ -2390,90 +5232,204 @@ namespace vekt
 
 		if (segments == 0) segments = 10;
 
-		segments = math::min(math::max(1, segments), 90);
+		segments = math::min(math::max(1, segments), unit_arcs::max_segments);
 
-		// top left
-		{
-			const vec2 center = vec2(min.x + r, min.y + r);
-			for (int i = 0; i <= segments; ++i)
-			{
+		const unsigned int n	 = static_cast<unsigned int>(segments) + 1;
+		const unsigned int start = out_path.size();
+		out_path.resize(start + n * 4);
 
-				const float target_angle  = DEG_2_RAD * (270.0f + (90.0f / segments) * i);
-				const vec2	point_on_unit = vec2(math::sin(target_angle), -math::cos(target_angle)) * r;
-				const vec2	point		  = center + point_on_unit;
-				out_path.push_back(point);
-			}
-		}
-		// top right
+		const vec2* arc = g_unit_arcs.get(segments);
+		vec2*		tl	= out_path.data() + start;
+		vec2*		tr	= tl + n;
+		vec2*		br	= tr + n;
+		vec2*		bl	= br + n;
+
+		const float left   = min.x + r;
+		const float top	   = min.y + r;
+		const float right  = max.x - r;
+		const float bottom = max.y - r;
+
+		// Corners go clockwise from top left, each one a rotation of the same quarter arc.
+		for (unsigned int i = 0; i < n; i++)
 		{
-			const vec2 center = vec2(max.x - r, min.y + r);
-			for (int i = 0; i <= segments; ++i)
-			{
+			const float sn = arc[i].x * r;
+			const float cs = arc[i].y * r;
+			tl[i]		   = {left - cs, top - sn};
+			tr[i]		   = {right + sn, top - cs};
+			br[i]		   = {right + cs, bottom + sn};
+			bl[i]		   = {left - sn, bottom + cs};
+		}
+	}
+	int builder::get_corner_segments(const vec2& min, const vec2& max, float rounding, unsigned int segments) const
+	{
+		if (segments != 0) return static_cast<int>(math::min(segments, static_cast<unsigned int>(unit_arcs::max_segments)));
+		if (_tessellation_tolerance <= 0.0f) return 10;
+
+		// Radius as it ends up on screen, scaled by the larger axis of the current transform.
+		const float scale  = sqrt(math::max(_transform.a * _transform.a + _transform.b * _transform.b, _transform.c * _transform.c + _transform.d * _transform.d));
+		const float radius = math::min(rounding, math::min((max.x - min.x) * 0.5f, (max.y - min.y) * 0.5f)) * scale;
+		if (radius <= _tessellation_tolerance) return 1;
+
+		// A chord spanning angle t deviates from the arc by radius * (1 - cos(t / 2)).
+		const float max_angle = 2.0f * math::acos(1.0f - _tessellation_tolerance / radius);
+		const int	count	  = static_cast<int>(math::ceilf((M_PI * 0.5f) / max_angle));
+		return math::clamp(count, 1, unit_arcs::max_segments);
+	}
 
-				const float target_angle  = DEG_2_RAD * ((90.0f / segments) * i);
-				const vec2	point_on_unit = vec2(math::sin(target_angle), -math::cos(target_angle)) * r;
-				const vec2	point		  = center + point_on_unit;
-				out_path.push_back(point);
-			}
+	void builder::generate_sharp_rect(pod_vector<vec2>& out_path, const vec2& min, const vec2& max)
+	{
+		out_path.push_back({min.x, min.y}); // Top-left
+		out_path.push_back({max.x, min.y}); // Top-right
+		out_path.push_back({max.x, max.y}); // Bottom-right
+		out_path.push_back({min.x, max.y}); // Bottom-left
+	}
+
+	namespace
+	{
+		template <typename T>
+		void grow_span(span_arena<T>& arena, T*& start, unsigned int& max, unsigned int used, unsigned int count)
+		{
+			unsigned int capacity = math::max(count, max * 2);
+			T*			 span	  = arena.allocate(capacity);
+			if (used > 0) MEMCPY(span, start, sizeof(T) * used);
+			arena.free(start, max);
+			start = span;
+			max	  = capacity;
 		}
+	}
+
+	void draw_buffer::grow_vertices(unsigned int count)
+	{
+		// Indices are 16 bit.
+		ASSERT(count <= 65536);
+		grow_span(_arenas->vertices, vertex_start, _max_vertices, vertex_count, count);
+	}
+
+	void draw_buffer::grow_indices(unsigned int count) { grow_span(_arenas->indices, index_start, _max_indices, index_count, count); }
+
+	void draw_buffer::grow_instances(unsigned int count) { grow_span(_arenas->instances, instance_start, _max_instances, instance_count, count); }
+
+	void draw_buffer::release()
+	{
+		_arenas->vertices.free(vertex_start, _max_vertices);
+		_arenas->indices.free(index_start, _max_indices);
+		_arenas->instances.free(instance_start, _max_instances);
+		vertex_start   = nullptr;
+		index_start	   = nullptr;
+		instance_start = nullptr;
+		_max_vertices = _max_indices = _max_instances = 0;
+	}
 
-		// bottom right
+	namespace
+	{
+		// Clips match on a 0.1 grid, the same tolerance vec4::equals gives.
+		struct draw_buffer_key
 		{
-			const vec2 center = vec2(max.x - r, max.y - r);
-			for (int i = 0; i <= segments; ++i)
+			int			 clip[4];
+			unsigned int draw_order;
+			unsigned int viewport;
+			void*		 user_data;
+			font*		 used_font;
+
+			bool operator==(const draw_buffer_key& o) const
 			{
+				return clip[0] == o.clip[0] && clip[1] == o.clip[1] && clip[2] == o.clip[2] && clip[3] == o.clip[3] && draw_order == o.draw_order && viewport == o.viewport && user_data == o.user_data && used_font == o.used_font;
+			}
 
-				const float target_angle  = DEG_2_RAD * (90.0f + (90.0f / segments) * i);
-				const vec2	point_on_unit = vec2(math::sin(target_angle), -math::cos(target_angle)) * r;
-				const vec2	point		  = center + point_on_unit;
-				out_path.push_back(point);
+			unsigned int hash() const
+			{
+				unsigned long long h = 14695981039346656037ull;
+				auto			   mix = [&h](unsigned long long v) { h = (h ^ v) * 1099511628211ull; };
+				for (int c : clip)
+					mix(static_cast<unsigned int>(c));
+				mix(draw_order);
+				mix(viewport);
+				mix(reinterpret_cast<size_t>(user_data));
+				mix(reinterpret_cast<size_t>(used_font));
+				return static_cast<unsigned int>(h ^ (h >> 32));
 			}
-		}
+		};
+
+		inline int quantize_clip(float v) { return static_cast<int>(v * 10.0f + (v >= 0.0f ? 0.5f : -0.5f)); }
 
-		// bottom left
+		inline draw_buffer_key make_draw_buffer_key(const vec4& clip, unsigned int draw_order, void* user_data, font* fnt, unsigned int viewport)
 		{
-			const vec2 center = vec2(min.x + r, max.y - r);
-			for (int i = 0; i <= segments; ++i)
-			{
+			return {{quantize_clip(clip.x), quantize_clip(clip.y), quantize_clip(clip.z), quantize_clip(clip.w)}, draw_order, viewport, user_data, fnt};
+		}
 
-				const float target_angle  = DEG_2_RAD * (180.0f + (90.0f / segments) * i);
-				const vec2	point_on_unit = vec2(math::sin(target_angle), -math::cos(target_angle)) * r;
-				const vec2	point		  = center + point_on_unit;
-				out_path.push_back(point);
-			}
+		inline draw_buffer_key make_draw_buffer_key(const draw_buffer& db) { return make_draw_buffer_key(db.clip, db.draw_order, db.user_data, db.used_font, db.viewport); }
+	}
+
+	void builder::rebuild_draw_buffer_table()
+	{
+		unsigned int size = 16;
+		while (size < (_draw_buffers.size() + 1) * 2)
+			size *= 2;
+
+		_draw_buffer_table.resize(size);
+		for (unsigned int& e : _draw_buffer_table)
+			e = 0;
+
+		// Entries are index + 1, 0 is empty.
+		const unsigned int mask = size - 1;
+		for (unsigned int i = 0; i < _draw_buffers.size(); i++)
+		{
+			unsigned int slot = make_draw_buffer_key(_draw_buffers[i]).hash() & mask;
+			while (_draw_buffer_table[slot] != 0)
+				slot = (slot + 1) & mask;
+			_draw_buffer_table[slot] = i + 1;
 		}
+
+		_draw_buffer_table_dirty = false;
+		_last_draw_buffer		 = 0xFFFFFFFF;
 	}
-	void builder::generate_sharp_rect(pod_vector<vec2>& out_path, const vec2& min, const vec2& max)
+
+	builder::draw_totals builder::get_draw_totals() const
 	{
-		out_path.push_back({min.x, min.y}); // Top-left
-		out_path.push_back({max.x, min.y}); // Top-right
-		out_path.push_back({max.x, max.y}); // Bottom-right
-		out_path.push_back({min.x, max.y}); // Bottom-left
+		draw_totals totals = {.buffers = _draw_buffers.size()};
+		for (const draw_buffer& db : _draw_buffers)
+		{
+			totals.vertices += db.vertex_count;
+			totals.indices += db.index_count;
+			totals.instances += db.instance_count;
+		}
+		return totals;
 	}
 
 	draw_buffer* builder::get_draw_buffer(unsigned int draw_order, void* user_data, font* fnt)
 	{
-		const vec4& clip = get_current_clip();
+		const vec4&			  clip = get_current_clip();
+		const draw_buffer_key key  = make_draw_buffer_key(clip, draw_order, user_data, fnt, _viewport_tag);
 
-		for (draw_buffer& db : _draw_buffers)
+		// Consecutive primitives mostly share a buffer.
+		if (!_draw_buffer_table_dirty && _last_draw_buffer < _draw_buffers.size() && make_draw_buffer_key(_draw_buffers[_last_draw_buffer]) == key) return &_draw_buffers[_last_draw_buffer];
+
+		if (_draw_buffer_table_dirty || (_draw_buffers.size() + 1) * 2 > _draw_buffer_table.size()) rebuild_draw_buffer_table();
+
+		const unsigned int mask = _draw_buffer_table.size() - 1;
+		unsigned int	   slot = key.hash() & mask;
+		for (; _draw_buffer_table[slot] != 0; slot = (slot + 1) & mask)
 		{
-			if (db.clip.equals(clip) && db.draw_order == draw_order && db.user_data == user_data && db.used_font == fnt) { return &db; }
+			const unsigned int i = _draw_buffer_table[slot] - 1;
+			if (make_draw_buffer_key(_draw_buffers[i]) == key)
+			{
+				_last_draw_buffer = i;
+				return &_draw_buffers[i];
+			}
 		}
 
-		ASSERT(_buffer_counter < _buffer_count);
-
-		draw_buffer db	 = {};
-		db.clip			 = clip;
-		db.draw_order	 = draw_order;
-		db.user_data	 = user_data;
-		db.vertex_start	 = _vertex_buffer + _buffer_counter * _vertex_count_per_buffer;
-		db.index_start	 = _index_buffer + _buffer_counter * _index_count_per_buffer;
-		db.used_font	 = fnt;
-		db._max_vertices = _vertex_count_per_buffer;
-		db._max_indices	 = _index_count_per_buffer;
+		// Spans are taken on the first add.
+		draw_buffer db = {};
+		db.clip		   = clip;
+		db.draw_order  = draw_order;
+		db.viewport	   = _viewport_tag;
+		db.user_data   = user_data;
+		db.used_font   = fnt;
+		db._arenas	   = &_draw_arenas;
 
-		_buffer_counter++;
 		_draw_buffers.push_back(db);
+		_draw_buffer_table[slot] = _draw_buffers.size();
+		_last_draw_buffer		 = _draw_buffers.size() - 1;
 		return &_draw_buffers.get_back();
 	}
 